@@ -0,0 +1,85 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QTimer>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Runs initialization steps off the startup path, at the latest after a timeout counted from
+ * adding the first step. They can be triggered earlier, for example once the first frame was
+ * presented. Each step runs in its own iteration of the event loop, so input and frames are
+ * handled in between, and its duration is logged.
+ */
+class deferred_init
+{
+public:
+    explicit deferred_init(std::chrono::milliseconds timeout)
+        : timeout{timeout}
+    {
+        timer.setSingleShot(true);
+        QObject::connect(&timer, &QTimer::timeout, &timer, [this] { run_next(); });
+    }
+
+    void add_step(QString name, std::function<void()> step)
+    {
+        steps.emplace_back(std::move(name), std::move(step));
+        if (!triggered && !timer.isActive()) {
+            timer.start(timeout);
+        }
+    }
+
+    void trigger()
+    {
+        if (!triggered) {
+            triggered = true;
+            timer.start(0);
+        }
+    }
+
+    bool is_done() const
+    {
+        return triggered && steps.empty();
+    }
+
+private:
+    void run_next()
+    {
+        triggered = true;
+        if (steps.empty()) {
+            return;
+        }
+
+        auto [name, step] = std::move(steps.front());
+        steps.pop_front();
+
+        QElapsedTimer clock;
+        clock.start();
+        step();
+        qInfo("Deferred %s took %lld ms.",
+              qPrintable(name),
+              static_cast<long long>(clock.elapsed()));
+
+        if (!steps.empty()) {
+            timer.start(0);
+        }
+    }
+
+    std::deque<std::pair<QString, std::function<void()>>> steps;
+    std::chrono::milliseconds timeout;
+    QTimer timer;
+    bool triggered{false};
+};
+
+}
@@ -0,0 +1,339 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "launcher.h"
+
+#include <QDebug>
+#include <QFile>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+constexpr int terminate_timeout_ms{5000};
+constexpr std::chrono::milliseconds wait_interval{50};
+
+int pidfd_open(pid_t pid)
+{
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+}
+
+// Written to from the SIGCHLD handler, which is installed once and never removed.
+int sigchld_pipe[2]{-1, -1};
+struct sigaction previous_sigchld;
+
+void handle_sigchld(int signal, siginfo_t* info, void* context)
+{
+    auto const saved_errno = errno;
+    char const byte{0};
+    [[maybe_unused]] auto ret = write(sigchld_pipe[1], &byte, 1);
+    errno = saved_errno;
+
+    // Qt watches its own processes through the handler installed before.
+    if (previous_sigchld.sa_flags & SA_SIGINFO) {
+        previous_sigchld.sa_sigaction(signal, info, context);
+    } else if (previous_sigchld.sa_handler != SIG_DFL && previous_sigchld.sa_handler != SIG_IGN) {
+        previous_sigchld.sa_handler(signal);
+    }
+}
+
+// The signals we ignore or watch. Children start with their default handling.
+constexpr std::array reset_signals{SIGPIPE, SIGHUP, SIGINT, SIGTERM, SIGUSR1, SIGUSR2};
+
+/**
+ * Like posix_spawnp, but sets the fd limit in the child only, which posix_spawn has no attribute
+ * for. The child reports a failing exec through a pipe closed on exec, so this returns once the
+ * child executes as well. Between fork and exec only async-signal-safe calls are made.
+ */
+int fork_exec(pid_t& pid,
+              char* const argv[],
+              char* const environment[],
+              bool discard_output,
+              rlimit const& nofile_limit)
+{
+    int status_pipe[2];
+    if (pipe2(status_pipe, O_CLOEXEC) != 0) {
+        return errno;
+    }
+
+    // Signals are blocked so no handler of ours runs in the child before the exec.
+    sigset_t all_signals;
+    sigset_t previous_signals;
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &previous_signals);
+
+    pid = fork();
+    if (pid == 0) {
+        close(status_pipe[0]);
+        for (auto signal : reset_signals) {
+            ::signal(signal, SIG_DFL);
+        }
+        sigset_t no_signals;
+        sigemptyset(&no_signals);
+        sigprocmask(SIG_SETMASK, &no_signals, nullptr);
+
+        setrlimit(RLIMIT_NOFILE, &nofile_limit);
+
+        if (discard_output) {
+            auto const null_fd = open("/dev/null", O_WRONLY);
+            if (null_fd >= 0 && null_fd != STDOUT_FILENO) {
+                dup2(null_fd, STDOUT_FILENO);
+                close(null_fd);
+            }
+        }
+
+        execvpe(argv[0], argv, environment);
+        int const error{errno};
+        [[maybe_unused]] auto ret = write(status_pipe[1], &error, sizeof(error));
+        _exit(127);
+    }
+
+    auto error = pid < 0 ? errno : 0;
+    pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+    close(status_pipe[1]);
+
+    if (pid > 0) {
+        ssize_t size;
+        do {
+            size = read(status_pipe[0], &error, sizeof(error));
+        } while (size < 0 && errno == EINTR);
+
+        if (size == sizeof(error)) {
+            waitpid(pid, nullptr, 0);
+        } else {
+            error = 0;
+        }
+    }
+
+    close(status_pipe[0]);
+    return error;
+}
+
+}
+
+launcher::launcher(QProcessEnvironment const& environment, std::optional<rlimit> nofile_limit)
+    : nofile_limit{nofile_limit}
+{
+    for (auto const& key : environment.keys()) {
+        environment_strings.push_back(
+            QFile::encodeName(key + QLatin1Char('=') + environment.value(key)).toStdString());
+    }
+    for (auto& entry : environment_strings) {
+        environment_block.push_back(entry.data());
+    }
+    environment_block.push_back(nullptr);
+}
+
+launcher::~launcher()
+{
+    if (session_pid) {
+        kill(*session_pid, SIGTERM);
+
+        auto it = children.find(*session_pid);
+        if (it != children.end() && it->second.pidfd >= 0) {
+            pollfd fd{.fd = it->second.pidfd, .events = POLLIN, .revents = 0};
+            if (poll(&fd, 1, terminate_timeout_ms) <= 0) {
+                qWarning() << "Session process did not terminate in time.";
+            }
+            waitpid(*session_pid, nullptr, WNOHANG);
+        } else {
+            auto waited = std::chrono::milliseconds::zero();
+            while (waitpid(*session_pid, nullptr, WNOHANG) == 0) {
+                if (waited >= std::chrono::milliseconds(terminate_timeout_ms)) {
+                    qWarning() << "Session process did not terminate in time.";
+                    break;
+                }
+                usleep(std::chrono::microseconds(wait_interval).count());
+                waited += wait_interval;
+            }
+        }
+    }
+
+    for (auto& [pid, entry] : children) {
+        if (entry.pidfd >= 0) {
+            close(entry.pidfd);
+        }
+    }
+}
+
+bool launcher::launch(QStringList const& arguments)
+{
+    return spawn(arguments, false).has_value();
+}
+
+bool launcher::launch_session(QStringList const& arguments)
+{
+    session_pid = spawn(arguments, true);
+    return session_pid.has_value();
+}
+
+std::optional<pid_t> launcher::spawn(QStringList const& arguments, bool discard_output)
+{
+    if (arguments.isEmpty()) {
+        return {};
+    }
+
+    std::vector<std::string> argument_strings;
+    for (auto const& argument : arguments) {
+        argument_strings.push_back(QFile::encodeName(argument).toStdString());
+    }
+    std::vector<char*> argv;
+    for (auto& argument : argument_strings) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    // Children start with default handling of our signals and with an unblocked signal mask.
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+
+    sigset_t default_signals;
+    sigset_t no_signals;
+    sigemptyset(&default_signals);
+    sigemptyset(&no_signals);
+    for (auto signal : reset_signals) {
+        sigaddset(&default_signals, signal);
+    }
+    posix_spawnattr_setsigdefault(&attributes, &default_signals);
+    posix_spawnattr_setsigmask(&attributes, &no_signals);
+    posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK);
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    if (discard_output) {
+        posix_spawn_file_actions_addopen(
+            &file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    }
+
+    pid_t pid;
+    auto const begin = std::chrono::steady_clock::now();
+    auto const error = nofile_limit
+        ? fork_exec(pid, argv.data(), environment_block.data(), discard_output, *nofile_limit)
+        : posix_spawnp(
+            &pid, argv.front(), &file_actions, &attributes, argv.data(), environment_block.data());
+    auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin);
+    posix_spawn_file_actions_destroy(&file_actions);
+    posix_spawnattr_destroy(&attributes);
+
+    if (error) {
+        qWarning() << "Failed to launch" << arguments.front() << ":" << strerror(error);
+        return {};
+    }
+
+    qInfo("Launched %s in %lld us.",
+          qPrintable(arguments.front()),
+          static_cast<long long>(latency.count()));
+
+    watch(pid);
+    return pid;
+}
+
+void launcher::watch(pid_t pid)
+{
+    auto const pidfd = pidfd_open(pid);
+    if (pidfd < 0) {
+        qDebug() << "No pidfd for launched process" << pid << ":" << strerror(errno);
+        watch_sigchld();
+        children.emplace(pid, child{pid, -1, nullptr});
+
+        // It might have exited before the handler was installed.
+        reap(pid);
+        return;
+    }
+
+    auto notifier = std::make_unique<QSocketNotifier>(pidfd, QSocketNotifier::Read);
+    QObject::connect(
+        notifier.get(), &QSocketNotifier::activated, this, [this, pid] { reap(pid); });
+    children.emplace(pid, child{pid, pidfd, std::move(notifier)});
+}
+
+void launcher::watch_sigchld()
+{
+    if (sigchld_notifier) {
+        return;
+    }
+
+    if (sigchld_pipe[0] < 0) {
+        if (pipe2(sigchld_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+            qWarning() << "Failed to watch launched processes:" << strerror(errno);
+            return;
+        }
+
+        struct sigaction action = {};
+        action.sa_sigaction = handle_sigchld;
+        action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGCHLD, &action, &previous_sigchld);
+    }
+
+    sigchld_notifier = std::make_unique<QSocketNotifier>(sigchld_pipe[0], QSocketNotifier::Read);
+    QObject::connect(sigchld_notifier.get(), &QSocketNotifier::activated, this, [this] {
+        char buffer[64];
+        while (read(sigchld_pipe[0], buffer, sizeof(buffer)) > 0) { }
+        reap_all();
+    });
+}
+
+void launcher::reap_all()
+{
+    std::vector<pid_t> watched;
+    for (auto const& [pid, entry] : children) {
+        if (entry.pidfd < 0) {
+            watched.push_back(pid);
+        }
+    }
+    for (auto pid : watched) {
+        reap(pid);
+    }
+}
+
+void launcher::reap(pid_t pid)
+{
+    auto it = children.find(pid);
+    if (it == children.end()) {
+        return;
+    }
+
+    int status{0};
+    if (waitpid(pid, &status, WNOHANG) != pid) {
+        return;
+    }
+
+    // Called from the notifier's own activation, so it must not be deleted right away.
+    if (it->second.notifier) {
+        it->second.notifier->setEnabled(false);
+        it->second.notifier.release()->deleteLater();
+        close(it->second.pidfd);
+    }
+    children.erase(it);
+
+    if (pid != session_pid) {
+        return;
+    }
+
+    session_pid.reset();
+    if (WIFSIGNALED(status)) {
+        Q_EMIT session_finished(-1, true);
+    } else {
+        Q_EMIT session_finished(WEXITSTATUS(status), false);
+    }
+}
+
+}
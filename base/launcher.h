@@ -0,0 +1,79 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QProcessEnvironment>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <vector>
+
+namespace theseus_ship::base
+{
+
+/**
+ * Starts the session and autostart applications with posix_spawn. The environment block is
+ * built once and shared by all of them. Spawning returns as soon as the child executes, so all
+ * applications start up in parallel. The spawn latency is logged per application.
+ *
+ * When children need a lower fd limit than the compositor they are forked instead, as posix_spawn
+ * cannot set limits. The limit is set in the child only, the compositor keeps its raised one.
+ *
+ * Children are reaped through a pidfd each. On kernels without pidfds they are reaped on SIGCHLD
+ * instead. The session process is terminated when the launcher is destroyed.
+ *
+ * Like with QProcess before, the output of the session process is discarded and only its errors
+ * are forwarded. Other applications inherit both channels, as detached processes did.
+ */
+class launcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// The fd limit is set to @p nofile_limit in children, if given.
+    launcher(QProcessEnvironment const& environment, std::optional<rlimit> nofile_limit);
+    ~launcher() override;
+
+    /// Starts an application with the program in the first argument. Returns false on failure.
+    bool launch(QStringList const& arguments);
+
+    /// Like launch, but session_finished is emitted when the application exits.
+    bool launch_session(QStringList const& arguments);
+
+Q_SIGNALS:
+    void session_finished(int exit_code, bool crashed);
+
+private:
+    struct child {
+        pid_t pid;
+
+        /// Without a pidfd the child is reaped on SIGCHLD.
+        int pidfd;
+        std::unique_ptr<QSocketNotifier> notifier;
+    };
+
+    std::optional<pid_t> spawn(QStringList const& arguments, bool discard_output);
+    void watch(pid_t pid);
+    void watch_sigchld();
+    void reap(pid_t pid);
+    void reap_all();
+
+    std::vector<std::string> environment_strings;
+    std::vector<char*> environment_block;
+    std::optional<rlimit> nofile_limit;
+
+    std::map<pid_t, child> children;
+    std::optional<pid_t> session_pid;
+    std::unique_ptr<QSocketNotifier> sigchld_notifier;
+};
+
+}
@@ -0,0 +1,168 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "scheduling.h"
+
+#include <config-theseus-ship.h>
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+#include <sys/resource.h>
+
+#if HAVE_LIBCAP
+#include <sys/capability.h>
+#endif
+
+namespace theseus_ship::base
+{
+
+namespace
+{
+
+bool set_realtime(int policy, int& priority)
+{
+    priority
+        = std::clamp(priority, sched_get_priority_min(policy), sched_get_priority_max(policy));
+
+    sched_param param{.sched_priority = priority};
+    return sched_setscheduler(0, policy | SCHED_RESET_ON_FORK, &param) == 0;
+}
+
+bool set_nice(int& priority)
+{
+    priority = std::clamp(priority, -20, 19);
+
+    // Also for the normal policy resetting on fork makes children start with a nice value of 0.
+    sched_param param{.sched_priority = 0};
+    if (sched_setscheduler(0, SCHED_OTHER | SCHED_RESET_ON_FORK, &param) != 0) {
+        return false;
+    }
+
+    // On Linux this only affects the calling thread.
+    return setpriority(PRIO_PROCESS, 0, priority) == 0;
+}
+
+void drop_nice_capability()
+{
+#if HAVE_LIBCAP
+    auto caps = cap_get_proc();
+    if (!caps) {
+        return;
+    }
+
+    cap_value_t const nice_cap[] = {CAP_SYS_NICE};
+    cap_set_flag(caps, CAP_EFFECTIVE, 1, nice_cap, CAP_CLEAR);
+    cap_set_flag(caps, CAP_PERMITTED, 1, nice_cap, CAP_CLEAR);
+    cap_set_flag(caps, CAP_INHERITABLE, 1, nice_cap, CAP_CLEAR);
+
+    if (cap_set_proc(caps) != 0) {
+        qWarning() << "Failed to drop CAP_SYS_NICE:" << strerror(errno);
+    }
+    cap_free(caps);
+#endif
+}
+
+}
+
+std::optional<scheduling_policy> scheduling_policy_from_string(QString const& name)
+{
+    if (name == QLatin1String("normal")) {
+        return scheduling_policy::normal;
+    }
+    if (name == QLatin1String("nice")) {
+        return scheduling_policy::nice;
+    }
+    if (name == QLatin1String("rr")) {
+        return scheduling_policy::round_robin;
+    }
+    if (name == QLatin1String("fifo")) {
+        return scheduling_policy::fifo;
+    }
+    return {};
+}
+
+QString scheduling_policy_to_string(scheduling_policy policy)
+{
+    switch (policy) {
+    case scheduling_policy::normal:
+        return QStringLiteral("normal");
+    case scheduling_policy::nice:
+        return QStringLiteral("nice");
+    case scheduling_policy::round_robin:
+        return QStringLiteral("rr");
+    case scheduling_policy::fifo:
+        return QStringLiteral("fifo");
+    }
+    return {};
+}
+
+scheduling_config load_scheduling_config(KConfigGroup const& group)
+{
+    scheduling_config config;
+
+    auto const policy = group.readEntry("SchedulingPolicy", QString());
+    if (auto parsed = scheduling_policy_from_string(policy)) {
+        config.policy = *parsed;
+    } else if (!policy.isEmpty()) {
+        qWarning() << "Ignoring unknown scheduling policy" << policy;
+    }
+
+    config.priority = group.readEntry("SchedulingPriority", 0);
+    return config;
+}
+
+scheduling::scheduling(scheduling_config const& requested)
+    : applied_config{requested}
+{
+    auto success = true;
+
+    switch (requested.policy) {
+    case scheduling_policy::round_robin:
+        success = set_realtime(SCHED_RR, applied_config.priority);
+        break;
+    case scheduling_policy::fifo:
+        success = set_realtime(SCHED_FIFO, applied_config.priority);
+        break;
+    case scheduling_policy::nice:
+        success = set_nice(applied_config.priority);
+        break;
+    case scheduling_policy::normal:
+        applied_config.priority = 0;
+        break;
+    }
+
+    if (!success) {
+        qDebug() << "Failed to apply scheduling policy"
+                 << scheduling_policy_to_string(requested.policy) << "with priority"
+                 << applied_config.priority << ":" << strerror(errno);
+        applied_config = {.policy = scheduling_policy::normal, .priority = 0};
+    }
+
+    drop_nice_capability();
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/Scheduling"), this, QDBusConnection::ExportScriptableContents);
+}
+
+scheduling_config const& scheduling::applied() const
+{
+    return applied_config;
+}
+
+QString scheduling::policy() const
+{
+    return scheduling_policy_to_string(applied_config.policy);
+}
+
+int scheduling::priority() const
+{
+    return applied_config.priority;
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <optional>
+
+namespace theseus_ship::base
+{
+
+enum class scheduling_policy {
+    normal,
+    nice,
+    round_robin,
+    fifo,
+};
+
+std::optional<scheduling_policy> scheduling_policy_from_string(QString const& name);
+QString scheduling_policy_to_string(scheduling_policy policy);
+
+struct scheduling_config {
+    scheduling_policy policy{scheduling_policy::round_robin};
+
+    /// The real-time priority or for the nice policy the nice value. Clamped to the valid range.
+    int priority{0};
+};
+
+/// Reads the SchedulingPolicy and SchedulingPriority entries of the Compositing group.
+scheduling_config load_scheduling_config(KConfigGroup const& group);
+
+/**
+ * Applies a scheduling policy to the calling thread. Meant for the main thread that renders and
+ * presents frames. Children and threads created afterwards start with the default policy again.
+ *
+ * Raising the policy requires CAP_SYS_NICE which the installed binary may have been given. The
+ * capability is dropped once the policy is applied. The resulting policy is exposed on D-Bus at
+ * the /Scheduling object.
+ */
+class scheduling : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.Scheduling")
+    Q_PROPERTY(QString policy READ policy CONSTANT)
+    Q_PROPERTY(int priority READ priority CONSTANT)
+
+public:
+    explicit scheduling(scheduling_config const& requested);
+
+    scheduling_config const& applied() const;
+
+    QString policy() const;
+    int priority() const;
+
+private:
+    scheduling_config applied_config;
+};
+
+}
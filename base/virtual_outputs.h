@@ -0,0 +1,84 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QRectF>
+#include <QSize>
+#include <map>
+#include <optional>
+
+namespace theseus_ship::base
+{
+
+struct virtual_outputs {
+    QSize size{1280, 720};
+    int count{1};
+    double scale{1.};
+
+    /// Values the backend variables had before, restored once the backend is created.
+    std::map<QByteArray, std::optional<QByteArray>> previous_environment;
+};
+
+/**
+ * Makes the wlroots backend create only headless outputs and render in software. Must be called
+ * before the platform is created. No input devices are opened, so this also works without a
+ * seat, for example on build machines or in CI.
+ */
+inline void setup_virtual_backend(virtual_outputs& outputs)
+{
+    auto set = [&outputs](char const* name, QByteArray const& value) {
+        auto& previous = outputs.previous_environment[name];
+        if (qEnvironmentVariableIsSet(name)) {
+            previous = qgetenv(name);
+        }
+        qputenv(name, value);
+    };
+
+    set("WLR_BACKENDS", "headless");
+    set("WLR_HEADLESS_OUTPUTS", QByteArray::number(outputs.count));
+    set("WLR_LIBINPUT_NO_DEVICES", "1");
+    set("WLR_RENDERER", "pixman");
+    set("KWIN_COMPOSE", "Q");
+}
+
+/**
+ * Restores the environment changed by setup_virtual_backend. Must be called once the platform
+ * started, before the process environment for clients is taken. Otherwise every launched client
+ * and nested compositor would inherit the headless backend and software rendering.
+ */
+inline void restore_environment(virtual_outputs& outputs)
+{
+    for (auto const& [name, value] : outputs.previous_environment) {
+        if (value) {
+            qputenv(name.constData(), *value);
+        } else {
+            qunsetenv(name.constData());
+        }
+    }
+    outputs.previous_environment.clear();
+}
+
+/**
+ * The headless backend creates its outputs with a fixed mode. Sets the requested size as custom
+ * mode instead and places the outputs next to each other.
+ */
+template<typename Base>
+void apply_virtual_outputs(Base& base, virtual_outputs const& outputs)
+{
+    auto const logical_size = QSizeF(outputs.size) / outputs.scale;
+    double x{0};
+
+    for (auto output : base.outputs) {
+        auto state = output->wrapland_output()->get_state();
+        state.mode.size = outputs.size;
+        state.geometry = QRectF(QPointF(x, 0), logical_size);
+        output->apply_state(state);
+        x += logical_size.width();
+    }
+}
+
+}
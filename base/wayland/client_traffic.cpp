@@ -0,0 +1,338 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "client_traffic.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QVariantMap>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+namespace theseus_ship::base::wayland
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds check_interval{1};
+
+std::chrono::nanoseconds monotonic_now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+uint32_t padded(uint32_t size)
+{
+    return (size + 3) & ~3u;
+}
+
+/// The size of the message on the wire. Fds are sent out of band and not counted.
+uint64_t wire_size(wl_protocol_logger_message const& message)
+{
+    uint64_t size{8};
+    int index{0};
+
+    for (auto signature = message.message->signature; *signature; ++signature) {
+        if (std::isdigit(*signature) || *signature == '?') {
+            continue;
+        }
+        if (index >= message.arguments_count) {
+            break;
+        }
+
+        auto const& arg = message.arguments[index++];
+        switch (*signature) {
+        case 's':
+            size += 4 + (arg.s ? padded(strlen(arg.s) + 1) : 0);
+            break;
+        case 'a':
+            size += 4 + (arg.a ? padded(arg.a->size) : 0);
+            break;
+        case 'h':
+            break;
+        default:
+            size += 4;
+            break;
+        }
+    }
+
+    return size;
+}
+
+client_traffic_action action_from_string(QString const& action)
+{
+    if (action == QLatin1String("throttle")) {
+        return client_traffic_action::throttle;
+    }
+    if (action == QLatin1String("disconnect")) {
+        return client_traffic_action::disconnect;
+    }
+    return client_traffic_action::log;
+}
+
+double to_ms(std::chrono::nanoseconds time)
+{
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+}
+
+client_traffic_config load_client_traffic_config(KConfigGroup const& group)
+{
+    client_traffic_config config;
+    config.enabled = group.readEntry("TrafficAccounting", config.enabled);
+    config.max_requests = std::max(group.readEntry("TrafficMaxRequests", config.max_requests), 0);
+    config.max_commits = std::max(group.readEntry("TrafficMaxCommits", config.max_commits), 0);
+    config.max_dispatch_percent = std::clamp(
+        group.readEntry("TrafficMaxDispatchPercent", config.max_dispatch_percent), 0, 100);
+    config.action
+        = action_from_string(group.readEntry("TrafficAction", QStringLiteral("log")).toLower());
+    config.throttle_rate
+        = std::max(group.readEntry("TrafficThrottleRate", config.throttle_rate), 0);
+    return config;
+}
+
+client_traffic::client_traffic(protocol_observer& observer,
+                               wl_display* display,
+                               client_traffic_config const& config,
+                               frame_throttling* throttling)
+    : observer{observer}
+    , loop{wl_display_get_event_loop(display)}
+    , config{config}
+    , throttling{throttling}
+{
+    if (this->config.action == client_traffic_action::throttle && !throttling) {
+        qWarning() << "Frame throttling is disabled. Abusive Wayland clients are only logged.";
+        this->config.action = client_traffic_action::log;
+    }
+
+    sinks.push_back(observer.add_sink([this](auto type, auto const& message) {
+        if (type == WL_PROTOCOL_LOGGER_REQUEST) {
+            handle_request(message);
+        }
+    }));
+    sinks.push_back(observer.add_sink("wl_surface", "attach", [this](auto, auto const& message) {
+        if (message.arguments[0].o) {
+            auto& stats = get_client(wl_resource_get_client(message.resource));
+            stats.total.buffers++;
+            stats.window.buffers++;
+        }
+    }));
+    sinks.push_back(observer.add_sink("wl_surface", "commit", [this](auto, auto const& message) {
+        auto& stats = get_client(wl_resource_get_client(message.resource));
+        stats.total.commits++;
+        stats.window.commits++;
+    }));
+
+    connect(&check_timer, &QTimer::timeout, this, &client_traffic::check);
+    check_timer.start(check_interval);
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/ClientTraffic"), this, QDBusConnection::ExportScriptableContents);
+}
+
+client_traffic::~client_traffic()
+{
+    for (auto sink : sinks) {
+        observer.remove_sink(sink);
+    }
+
+    if (idle_source) {
+        wl_event_source_remove(idle_source);
+    }
+
+    for (auto& [client, listener] : client_listeners) {
+        wl_list_remove(&listener->listener.link);
+    }
+}
+
+void client_traffic::handle_request(wl_protocol_logger_message const& message)
+{
+    auto const now = monotonic_now();
+    close_dispatch(now);
+
+    auto& stats = get_client(wl_resource_get_client(message.resource));
+    auto const bytes = wire_size(message);
+
+    for (auto counters : {&stats.total, &stats.window}) {
+        counters->requests++;
+        counters->bytes += bytes;
+    }
+    stats.interfaces[wl_resource_get_class(message.resource)]++;
+
+    dispatching = &stats;
+    dispatch_start = now;
+
+    // Idle sources run once the event loop dispatched all clients with pending requests.
+    if (!idle_source) {
+        idle_source = wl_event_loop_add_idle(loop, &client_traffic::handle_idle, this);
+    }
+}
+
+void client_traffic::close_dispatch(std::chrono::nanoseconds now)
+{
+    if (!dispatching) {
+        return;
+    }
+
+    auto const duration = now - dispatch_start;
+    dispatching->total.dispatch += duration;
+    dispatching->window.dispatch += duration;
+    dispatching = nullptr;
+}
+
+client_traffic::client_stats& client_traffic::get_client(wl_client* client)
+{
+    if (auto it = clients.find(client); it != clients.end()) {
+        return *it->second;
+    }
+
+    auto stats = std::make_unique<client_stats>();
+    wl_client_get_credentials(client, &stats->pid, nullptr, nullptr);
+
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(stats->pid));
+    if (comm.open(QIODevice::ReadOnly)) {
+        stats->command = QString::fromUtf8(comm.readAll()).trimmed();
+    }
+
+    auto listener = std::make_unique<client_listener>();
+    listener->listener.notify = &client_traffic::handle_client_destroyed;
+    listener->traffic = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+    client_listeners.emplace(client, std::move(listener));
+
+    return *clients.emplace(client, std::move(stats)).first->second;
+}
+
+bool client_traffic::is_abusive(counters const& rates) const
+{
+    auto const dispatch_percent = 100 * rates.dispatch / std::chrono::nanoseconds(check_interval);
+
+    return (config.max_requests && rates.requests > static_cast<uint64_t>(config.max_requests))
+        || (config.max_commits && rates.commits > static_cast<uint64_t>(config.max_commits))
+        || (config.max_dispatch_percent && dispatch_percent > config.max_dispatch_percent);
+}
+
+void client_traffic::check()
+{
+    std::vector<wl_client*> abusive;
+
+    for (auto& [client, stats] : clients) {
+        stats->last_second = stats->window;
+        stats->window = {};
+
+        auto const was_abusive = stats->abusive;
+        stats->abusive = is_abusive(stats->last_second);
+
+        if (stats->abusive && !was_abusive) {
+            qWarning().nospace() << "Wayland client " << stats->command << " with pid "
+                                 << stats->pid << " sent " << stats->last_second.requests
+                                 << " requests with " << stats->last_second.commits
+                                 << " commits and took "
+                                 << to_ms(stats->last_second.dispatch)
+                                 << " ms to dispatch in the last second.";
+
+            if (config.action == client_traffic_action::throttle) {
+                throttling->limit(client, config.throttle_rate);
+            } else if (config.action == client_traffic_action::disconnect) {
+                abusive.push_back(client);
+            }
+        } else if (!stats->abusive && was_abusive
+                   && config.action == client_traffic_action::throttle) {
+            throttling->unlimit(client);
+        }
+    }
+
+    // Destroying a client calls back into handle_client_destroyed, so do it after iterating.
+    for (auto client : abusive) {
+        qWarning() << "Disconnecting abusive Wayland client" << clients.at(client)->command;
+        wl_client_destroy(client);
+    }
+}
+
+QVariantList client_traffic::topClients(int count) const
+{
+    std::vector<client_stats const*> sorted;
+    for (auto const& [client, stats] : clients) {
+        sorted.push_back(stats.get());
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto lhs, auto rhs) {
+        return lhs->total.dispatch > rhs->total.dispatch;
+    });
+
+    QVariantList result;
+    for (auto stats : sorted) {
+        if (result.size() >= count) {
+            break;
+        }
+
+        QVariantMap interfaces;
+        for (auto const& [name, requests] : stats->interfaces) {
+            interfaces.insert(QString::fromUtf8(name), static_cast<quint64>(requests));
+        }
+
+        result.append(QVariantMap{
+            {QStringLiteral("pid"), static_cast<qint64>(stats->pid)},
+            {QStringLiteral("command"), stats->command},
+            {QStringLiteral("requests"), static_cast<quint64>(stats->total.requests)},
+            {QStringLiteral("bytes"), static_cast<quint64>(stats->total.bytes)},
+            {QStringLiteral("buffers"), static_cast<quint64>(stats->total.buffers)},
+            {QStringLiteral("commits"), static_cast<quint64>(stats->total.commits)},
+            {QStringLiteral("dispatchMs"), to_ms(stats->total.dispatch)},
+            {QStringLiteral("requestsPerSecond"),
+             static_cast<quint64>(stats->last_second.requests)},
+            {QStringLiteral("commitsPerSecond"), static_cast<quint64>(stats->last_second.commits)},
+            {QStringLiteral("dispatchMsPerSecond"), to_ms(stats->last_second.dispatch)},
+            {QStringLiteral("interfaces"), interfaces},
+            {QStringLiteral("abusive"), stats->abusive},
+        });
+    }
+    return result;
+}
+
+void client_traffic::reset()
+{
+    for (auto& [client, stats] : clients) {
+        stats->total = {};
+        stats->interfaces.clear();
+    }
+}
+
+void client_traffic::handle_idle(void* data)
+{
+    auto traffic = static_cast<client_traffic*>(data);
+
+    // Idle sources are removed by the event loop after running.
+    traffic->idle_source = nullptr;
+    traffic->close_dispatch(monotonic_now());
+}
+
+void client_traffic::handle_client_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout client_listener.
+    auto data = reinterpret_cast<client_listener*>(listener);
+    auto traffic = data->traffic;
+    auto client = data->client;
+
+    wl_list_remove(&listener->link);
+
+    if (auto it = traffic->clients.find(client); it != traffic->clients.end()) {
+        if (traffic->dispatching == it->second.get()) {
+            traffic->dispatching = nullptr;
+        }
+        traffic->clients.erase(it);
+    }
+    traffic->client_listeners.erase(client);
+}
+
+}
@@ -0,0 +1,137 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/frame_throttling.h"
+#include "base/wayland/protocol_observer.h"
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <sys/types.h>
+#include <vector>
+
+namespace theseus_ship::base::wayland
+{
+
+enum class client_traffic_action {
+    log,
+    throttle,
+    disconnect,
+};
+
+struct client_traffic_config {
+    /// Counting costs on every request, so it is off unless enabled.
+    bool enabled{false};
+
+    /// Requests per second above which a client is abusive. 0 disables the check.
+    int max_requests{20000};
+
+    /// Surface commits per second above which a client is abusive. 0 disables the check.
+    int max_commits{1000};
+
+    /// Share of a second in percent spent dispatching a client's requests above which it is
+    /// abusive. 0 disables the check.
+    int max_dispatch_percent{50};
+
+    /// Throttling only delays the frame callbacks of abusive clients. It slows clients that draw
+    /// on frame callbacks, but not clients sending requests without waiting for any. Only
+    /// disconnecting stops those. Throttling requires the KWIN_BUILD_FRAME_THROTTLING build
+    /// option. Without it abusive clients are only logged.
+    client_traffic_action action{client_traffic_action::log};
+
+    /// Frame callbacks per second for abusive clients with the throttle action.
+    int throttle_rate{5};
+};
+
+/// Reads the TrafficAccounting, TrafficMaxRequests, TrafficMaxCommits,
+/// TrafficMaxDispatchPercent, TrafficAction and TrafficThrottleRate entries of the Wayland
+/// group. The action is log, throttle or disconnect.
+client_traffic_config load_client_traffic_config(KConfigGroup const& group);
+
+/**
+ * Counts the protocol traffic of each Wayland client: requests per interface, bytes received,
+ * attached buffers, commits and the time spent dispatching its requests. A dispatch lasts from a
+ * request until the next request of any client or until the event loop is idle again, so it
+ * includes the handlers and events they send.
+ *
+ * Once per second the rates are checked against the configured limits. Abusive clients are
+ * logged, get their frame callbacks throttled or are disconnected. The counters of the clients
+ * with most dispatch time are readable on D-Bus from the /ClientTraffic object.
+ */
+class client_traffic : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.ClientTraffic")
+
+public:
+    /// Throttling needs @p throttling, which may be null. The action falls back to log then.
+    client_traffic(protocol_observer& observer,
+                   wl_display* display,
+                   client_traffic_config const& config,
+                   frame_throttling* throttling);
+    ~client_traffic() override;
+
+public Q_SLOTS:
+    /// Per client with most dispatch time its pid, command, totals and rates of the last second.
+    Q_SCRIPTABLE QVariantList topClients(int count) const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct counters {
+        uint64_t requests{0};
+        uint64_t bytes{0};
+        uint64_t buffers{0};
+        uint64_t commits{0};
+        std::chrono::nanoseconds dispatch{0};
+    };
+
+    struct client_stats {
+        pid_t pid{0};
+        QString command;
+        counters total;
+        counters window;
+        counters last_second;
+        std::map<char const*, uint64_t> interfaces;
+        bool abusive{false};
+    };
+
+    struct client_listener {
+        wl_listener listener;
+        client_traffic* traffic;
+        wl_client* client;
+    };
+
+    void handle_request(wl_protocol_logger_message const& message);
+    void close_dispatch(std::chrono::nanoseconds now);
+    client_stats& get_client(wl_client* client);
+    void check();
+    bool is_abusive(counters const& rates) const;
+
+    static void handle_idle(void* data);
+    static void handle_client_destroyed(wl_listener* listener, void* data);
+
+    protocol_observer& observer;
+    wl_event_loop* loop;
+    client_traffic_config config;
+    frame_throttling* throttling;
+    std::vector<int> sinks;
+
+    std::map<wl_client*, std::unique_ptr<client_stats>> clients;
+    std::map<wl_client*, std::unique_ptr<client_listener>> client_listeners;
+    QTimer check_timer;
+
+    client_stats* dispatching{nullptr};
+    std::chrono::nanoseconds dispatch_start{0};
+    wl_event_source* idle_source{nullptr};
+};
+
+}
@@ -0,0 +1,311 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "fd_accounting.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <vector>
+
+namespace theseus_ship::base::wayland
+{
+
+namespace
+{
+
+constexpr std::chrono::seconds check_interval{2};
+
+// Warn when the process uses this share of its fd limit.
+constexpr double process_warning_share{0.8};
+
+struct fd_request {
+    char const* interface;
+    char const* name;
+    fd_kind kind;
+};
+
+constexpr fd_request fd_requests[] = {
+    {"wl_shm", "create_pool", fd_kind::shm},
+    {"zwp_linux_buffer_params_v1", "add", fd_kind::dmabuf},
+    {"zwp_linux_surface_synchronization_v1", "set_acquire_fence", fd_kind::sync},
+    {"wp_linux_drm_syncobj_manager_v1", "import_timeline", fd_kind::sync},
+    {"wl_data_offer", "receive", fd_kind::pipe},
+    {"zwp_primary_selection_offer_v1", "receive", fd_kind::pipe},
+    {"zwlr_data_control_offer_v1", "receive", fd_kind::pipe},
+};
+
+fd_kind kind_of(wl_protocol_logger_message const& message)
+{
+    for (auto const& request : fd_requests) {
+        if (protocol_observer::is_message(message, request.interface, request.name)) {
+            return request.kind;
+        }
+    }
+    return fd_kind::other;
+}
+
+char const* kind_to_string(fd_kind kind)
+{
+    switch (kind) {
+    case fd_kind::shm:
+        return "shm";
+    case fd_kind::dmabuf:
+        return "dmabuf";
+    case fd_kind::sync:
+        return "sync";
+    case fd_kind::pipe:
+        return "pipe";
+    case fd_kind::other:
+        return "other";
+    }
+    return "other";
+}
+
+size_t count_process_fds()
+{
+    std::error_code error;
+    std::filesystem::directory_iterator it("/proc/self/fd", error);
+    if (error) {
+        return 0;
+    }
+    return std::distance(it, std::filesystem::directory_iterator());
+}
+
+size_t fd_limit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return 0;
+    }
+    return limit.rlim_cur;
+}
+
+}
+
+fd_accounting_config load_fd_accounting_config(KConfigGroup const& group)
+{
+    fd_accounting_config config;
+    config.soft_limit = std::max(group.readEntry("FdSoftLimit", config.soft_limit), 0);
+    config.hard_limit = std::max(group.readEntry("FdHardLimit", config.hard_limit), 0);
+    return config;
+}
+
+fd_accounting::fd_accounting(protocol_observer& observer, fd_accounting_config const& config)
+    : observer{observer}
+    , config{config}
+{
+    // Only messages carrying fds, marked with h in their signature, are passed on.
+    sink = observer.add_sink(
+        [](auto const& message) { return strchr(message.message->signature, 'h') != nullptr; },
+        [this](auto type, auto const& message) {
+            if (type == WL_PROTOCOL_LOGGER_REQUEST) {
+                handle_request(message);
+            }
+        });
+
+    connect(&check_timer, &QTimer::timeout, this, &fd_accounting::check);
+    check_timer.start(check_interval);
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/FdAccounting"), this, QDBusConnection::ExportScriptableContents);
+}
+
+fd_accounting::~fd_accounting()
+{
+    observer.remove_sink(sink);
+
+    for (auto& [client, listener] : client_listeners) {
+        wl_list_remove(&listener->listener.link);
+    }
+}
+
+void fd_accounting::handle_request(wl_protocol_logger_message const& message)
+{
+    // Fds are marked with h in the signature. Digits give the version, ? makes it nullable.
+    auto signature = message.message->signature;
+    int index{0};
+    std::optional<fd_kind> kind;
+
+    for (; *signature; ++signature) {
+        if (std::isdigit(*signature) || *signature == '?') {
+            continue;
+        }
+        if (*signature == 'h' && index < message.arguments_count) {
+            if (!kind) {
+                kind = kind_of(message);
+            }
+            add_fd(wl_resource_get_client(message.resource), message.arguments[index].h, *kind);
+        }
+        index++;
+    }
+}
+
+void fd_accounting::add_fd(wl_client* client, int fd, fd_kind kind)
+{
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return;
+    }
+
+    if (kind == fd_kind::other && S_ISFIFO(info.st_mode)) {
+        kind = fd_kind::pipe;
+    }
+
+    auto& data = get_client(client);
+    data.fds[fd] = {kind, info.st_dev, info.st_ino};
+    data.high_water = std::max(data.high_water, data.fds.size());
+}
+
+fd_accounting::client_fds& fd_accounting::get_client(wl_client* client)
+{
+    if (auto it = clients.find(client); it != clients.end()) {
+        return *it->second;
+    }
+
+    auto data = std::make_unique<client_fds>();
+    wl_client_get_credentials(client, &data->pid, nullptr, nullptr);
+
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(data->pid));
+    if (comm.open(QIODevice::ReadOnly)) {
+        data->command = QString::fromUtf8(comm.readAll()).trimmed();
+    }
+
+    auto listener = std::make_unique<client_listener>();
+    listener->listener.notify = &fd_accounting::handle_client_destroyed;
+    listener->accounting = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+    client_listeners.emplace(client, std::move(listener));
+
+    return *clients.emplace(client, std::move(data)).first->second;
+}
+
+void fd_accounting::check()
+{
+    std::vector<wl_client*> abusive;
+
+    for (auto& [client, data] : clients) {
+        // An fd is still held when its number refers to the same file as when it was received.
+        std::erase_if(data->fds, [](auto const& entry) {
+            struct stat info;
+            return fstat(entry.first, &info) != 0 || info.st_dev != entry.second.device
+                || info.st_ino != entry.second.inode;
+        });
+
+        auto const held = static_cast<int>(data->fds.size());
+
+        if (config.hard_limit && held > config.hard_limit) {
+            qWarning() << "Disconnecting Wayland client" << data->command << "with pid"
+                       << data->pid << "holding" << held << "file descriptors.";
+            abusive.push_back(client);
+            continue;
+        }
+
+        if (config.soft_limit && held > config.soft_limit) {
+            if (!data->warned) {
+                qWarning() << "Wayland client" << data->command << "with pid" << data->pid
+                           << "holds" << held << "file descriptors.";
+                data->warned = true;
+            }
+        } else {
+            data->warned = false;
+        }
+    }
+
+    // Destroying a client calls back into handle_client_destroyed, so do it after iterating.
+    for (auto client : abusive) {
+        wl_client_destroy(client);
+    }
+
+    check_process();
+}
+
+void fd_accounting::check_process()
+{
+    process_fds = count_process_fds();
+    process_high_water = std::max(process_high_water, process_fds);
+
+    auto const limit = fd_limit();
+    if (!limit) {
+        return;
+    }
+
+    if (process_fds > limit * process_warning_share) {
+        if (!process_warned) {
+            qWarning() << "Compositor uses" << process_fds << "of" << limit
+                       << "file descriptors. Top consumer:" << topConsumers(1);
+            process_warned = true;
+        }
+    } else {
+        process_warned = false;
+    }
+}
+
+QVariantList fd_accounting::topConsumers(int count) const
+{
+    std::vector<client_fds const*> sorted;
+    for (auto const& [client, data] : clients) {
+        sorted.push_back(data.get());
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto lhs, auto rhs) {
+        return lhs->fds.size() > rhs->fds.size();
+    });
+
+    QVariantList result;
+    for (auto data : sorted) {
+        if (result.size() >= count) {
+            break;
+        }
+
+        std::map<fd_kind, quint64> kinds;
+        for (auto const& [fd, held] : data->fds) {
+            kinds[held.kind]++;
+        }
+
+        QVariantMap entry{
+            {QStringLiteral("pid"), static_cast<qint64>(data->pid)},
+            {QStringLiteral("command"), data->command},
+            {QStringLiteral("fds"), static_cast<quint64>(data->fds.size())},
+            {QStringLiteral("highWater"), static_cast<quint64>(data->high_water)},
+        };
+        for (auto kind :
+             {fd_kind::shm, fd_kind::dmabuf, fd_kind::sync, fd_kind::pipe, fd_kind::other}) {
+            entry.insert(QString::fromLatin1(kind_to_string(kind)), kinds[kind]);
+        }
+        result.append(entry);
+    }
+    return result;
+}
+
+QVariantMap fd_accounting::summary() const
+{
+    return {
+        {QStringLiteral("open"), static_cast<quint64>(count_process_fds())},
+        {QStringLiteral("limit"), static_cast<quint64>(fd_limit())},
+        {QStringLiteral("highWater"), static_cast<quint64>(process_high_water)},
+    };
+}
+
+void fd_accounting::handle_client_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout client_listener.
+    auto data = reinterpret_cast<client_listener*>(listener);
+    auto accounting = data->accounting;
+    auto client = data->client;
+
+    wl_list_remove(&listener->link);
+    accounting->clients.erase(client);
+    accounting->client_listeners.erase(client);
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/protocol_observer.h"
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantList>
+#include <QVariantMap>
+#include <map>
+#include <memory>
+#include <sys/types.h>
+
+namespace theseus_ship::base::wayland
+{
+
+enum class fd_kind {
+    shm,
+    dmabuf,
+    sync,
+    pipe,
+    other,
+};
+
+struct fd_accounting_config {
+    /// Number of held fds of a single client above which a warning is logged. 0 disables it.
+    int soft_limit{1024};
+
+    /// Number of held fds of a single client above which it is disconnected. 0 disables it, which
+    /// is the default.
+    int hard_limit{0};
+};
+
+/// Reads the FdSoftLimit and FdHardLimit entries of the Wayland group.
+fd_accounting_config load_fd_accounting_config(KConfigGroup const& group);
+
+/**
+ * Accounts the file descriptors the compositor received from each Wayland client, like shm pools,
+ * dmabuf planes, sync files and pipes. Every received fd is attributed to its client until a
+ * periodic check finds it closed. Clients going above the soft limit are warned about and above
+ * the hard limit, if one is set, disconnected.
+ *
+ * The process-wide fd count is checked against RLIMIT_NOFILE as well. A report of the top
+ * consumers and their high-water marks is available on D-Bus from the /FdAccounting object.
+ */
+class fd_accounting : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.FdAccounting")
+
+public:
+    fd_accounting(protocol_observer& observer, fd_accounting_config const& config);
+    ~fd_accounting() override;
+
+public Q_SLOTS:
+    /// Per client with most held fds its pid, command, fd counts by kind and high-water mark.
+    Q_SCRIPTABLE QVariantList topConsumers(int count) const;
+    /// Open fds of the whole process, its limit and high-water mark.
+    Q_SCRIPTABLE QVariantMap summary() const;
+
+private:
+    struct held_fd {
+        fd_kind kind;
+        dev_t device;
+        ino_t inode;
+    };
+
+    struct client_fds {
+        pid_t pid{0};
+        QString command;
+        std::map<int, held_fd> fds;
+        size_t high_water{0};
+        bool warned{false};
+    };
+
+    struct client_listener {
+        wl_listener listener;
+        fd_accounting* accounting;
+        wl_client* client;
+    };
+
+    void handle_request(wl_protocol_logger_message const& message);
+    void add_fd(wl_client* client, int fd, fd_kind kind);
+    client_fds& get_client(wl_client* client);
+    void check();
+    void check_process();
+
+    static void handle_client_destroyed(wl_listener* listener, void* data);
+
+    protocol_observer& observer;
+    fd_accounting_config config;
+    int sink;
+
+    std::map<wl_client*, std::unique_ptr<client_fds>> clients;
+    std::map<wl_client*, std::unique_ptr<client_listener>> client_listeners;
+    QTimer check_timer;
+
+    size_t process_fds{0};
+    size_t process_high_water{0};
+    bool process_warned{false};
+};
+
+}
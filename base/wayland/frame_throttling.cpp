@@ -0,0 +1,481 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "frame_throttling.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariantMap>
+#include <algorithm>
+#include <ctime>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include <wayland-server-protocol.h>
+
+namespace theseus_ship::base::wayland
+{
+
+namespace
+{
+
+frame_throttling* active_instance{nullptr};
+
+uint32_t monotonic_msec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint32_t>(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+}
+
+frame_throttling_config load_frame_throttling_config(KConfigGroup const& group)
+{
+    frame_throttling_config config;
+    config.hidden_rate = group.readEntry("HiddenRate", config.hidden_rate);
+
+    for (auto const& rule : group.readEntry("Rules", QStringList())) {
+        auto const separator = rule.lastIndexOf(QLatin1Char(':'));
+        if (separator <= 0) {
+            continue;
+        }
+        bool ok{false};
+        auto const rate = rule.mid(separator + 1).toInt(&ok);
+        if (ok) {
+            config.rules[rule.left(separator)] = rate;
+        }
+    }
+
+    return config;
+}
+
+frame_throttling::frame_throttling(protocol_observer& observer,
+                                   wl_display* display,
+                                   frame_throttling_config config)
+    : observer{observer}
+    , config{std::move(config)}
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) == 0) {
+        stand_in_client = wl_client_create(display, fds[0]);
+        if (stand_in_client) {
+            stand_in_notifier
+                = std::make_unique<QSocketNotifier>(fds[1], QSocketNotifier::Read);
+            connect(stand_in_notifier.get(), &QSocketNotifier::activated, this, [fd = fds[1]] {
+                char buffer[4096];
+                while (read(fd, buffer, sizeof(buffer)) > 0) { }
+            });
+        } else {
+            close(fds[0]);
+            close(fds[1]);
+        }
+    }
+    if (!stand_in_client) {
+        qWarning() << "Failed to create the client for frame throttling.";
+    }
+
+    sinks.push_back(observer.add_sink("wl_surface", "frame", [this](auto, auto const& message) {
+        get_client(wl_resource_get_client(message.resource))
+            .frame_callbacks.insert(message.arguments[0].n);
+    }));
+    sinks.push_back(observer.add_sink("wl_display", "sync", [this](auto, auto const& message) {
+        // The id of a frame callback that was never done can be reused for a sync callback.
+        auto const client = wl_resource_get_client(message.resource);
+        if (auto it = clients.find(client); it != clients.end()) {
+            it->second.frame_callbacks.erase(message.arguments[0].n);
+        }
+    }));
+    sinks.push_back(observer.add_sink("wl_callback", "done", [this](auto, auto const& message) {
+        if (stand_in_client && wl_resource_get_client(message.resource) == stand_in_client) {
+            hold_done(message.resource);
+        }
+    }));
+
+    active_instance = this;
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/FrameThrottling"), this, QDBusConnection::ExportScriptableContents);
+}
+
+frame_throttling::~frame_throttling()
+{
+    active_instance = nullptr;
+    for (auto sink : sinks) {
+        observer.remove_sink(sink);
+    }
+
+    // Clients must not wait forever for callbacks that are held back. Stand-ins still waiting
+    // for como are lost, which only happens on shutdown.
+    hidden_pids.clear();
+    limited_clients.clear();
+    apply();
+
+    for (auto& [client, state] : clients) {
+        for (auto& callback : state.callbacks) {
+            if (callback->stand_in) {
+                wl_list_remove(&callback->listener.link);
+            }
+        }
+    }
+
+    for (auto& [client, listener] : client_listeners) {
+        wl_list_remove(&listener->listener.link);
+    }
+
+    if (stand_in_client) {
+        auto const fd = static_cast<int>(stand_in_notifier->socket());
+        stand_in_notifier.reset();
+        wl_client_destroy(stand_in_client);
+        close(fd);
+    }
+}
+
+QString frame_throttling::script_path()
+{
+    return QStringLiteral(":/theseus-ship/frame_throttling.js");
+}
+
+frame_throttling* frame_throttling::instance()
+{
+    return active_instance;
+}
+
+bool frame_throttling::takes_callback(wl_client* client, uint32_t id)
+{
+    auto it = clients.find(client);
+    if (it == clients.end()) {
+        return false;
+    }
+
+    // wl_display.sync creates callbacks as well. Only frame callbacks are throttled.
+    return it->second.frame_callbacks.erase(id) && hidden(client);
+}
+
+wl_resource* frame_throttling::add_callback(wl_resource* resource)
+{
+    if (!stand_in_client) {
+        return nullptr;
+    }
+
+    // Id 0 allocates a server-side id on our own client, so the client never sees the stand-in.
+    auto stand_in = wl_resource_create(
+        stand_in_client, &wl_callback_interface, wl_resource_get_version(resource), 0);
+    if (!stand_in) {
+        return nullptr;
+    }
+
+    auto callback = std::make_unique<taken_callback>();
+    callback->listener.notify = &frame_throttling::handle_stand_in_destroyed;
+    callback->throttling = this;
+    callback->resource = resource;
+    callback->stand_in = stand_in;
+    wl_resource_add_destroy_listener(stand_in, &callback->listener);
+
+    auto const client = wl_resource_get_client(resource);
+    stand_ins.emplace(stand_in, client);
+    get_client(client).callbacks.push_back(std::move(callback));
+    return stand_in;
+}
+
+void frame_throttling::hold_done(wl_resource* stand_in)
+{
+    auto client_it = stand_ins.find(stand_in);
+    if (client_it == stand_ins.end()) {
+        return;
+    }
+
+    auto const client = client_it->second;
+    auto& state = clients.at(client);
+    auto callback = std::find_if(state.callbacks.begin(),
+                                 state.callbacks.end(),
+                                 [stand_in](auto const& callback) {
+                                     return callback->stand_in == stand_in;
+                                 });
+    if (callback == state.callbacks.end()) {
+        return;
+    }
+
+    (*callback)->done = true;
+    state.held_count++;
+
+    // Called while como sends the event, so the client's callback is released from the event
+    // loop instead of right away.
+    auto const data = hidden(client);
+    if (!data) {
+        // Shown again since the callback was requested.
+        state.release_timer->start(0);
+    } else if (data->rate > 0 && !state.release_timer->isActive()) {
+        state.release_timer->start(std::chrono::milliseconds(1000 / data->rate));
+    }
+}
+
+void frame_throttling::limit(wl_client* client, int rate)
+{
+    auto& state = get_client(client);
+    auto& data = limited_clients[client];
+    data.reason = QStringLiteral("limited");
+    data.rate = rate;
+
+    // A changed rate applies from the next held callback on.
+    if (rate == 0) {
+        state.release_timer->stop();
+    }
+}
+
+void frame_throttling::unlimit(wl_client* client)
+{
+    if (limited_clients.erase(client)) {
+        apply();
+    }
+}
+
+void frame_throttling::update(QString const& windows)
+{
+    struct pid_visibility {
+        QStringList resource_classes;
+        QString reason;
+        bool visible{false};
+    };
+
+    std::map<pid_t, pid_visibility> pids;
+    for (auto const& value : QJsonDocument::fromJson(windows.toUtf8()).array()) {
+        auto const window = value.toObject();
+        auto const pid = static_cast<pid_t>(window.value(QStringLiteral("pid")).toInt());
+        if (pid <= 0) {
+            continue;
+        }
+
+        auto& entry = pids[pid];
+        auto const resource_class = window.value(QStringLiteral("resourceClass")).toString();
+        if (!entry.resource_classes.contains(resource_class)) {
+            entry.resource_classes.append(resource_class);
+        }
+
+        auto const reason = window.value(QStringLiteral("reason")).toString();
+        if (reason.isEmpty()) {
+            entry.visible = true;
+        } else if (entry.reason.isEmpty()) {
+            entry.reason = reason;
+        }
+    }
+
+    hidden_pids.clear();
+    for (auto& [pid, entry] : pids) {
+        if (entry.visible) {
+            continue;
+        }
+
+        // With rules for several classes of one client the least throttling one wins.
+        auto rate = config.hidden_rate;
+        bool has_rule{false};
+        for (auto const& resource_class : entry.resource_classes) {
+            if (auto rule = config.rules.find(resource_class); rule != config.rules.end()) {
+                rate = has_rule ? std::max(rate, rule->second) : rule->second;
+                has_rule = true;
+            }
+        }
+        if (rate < 0) {
+            continue;
+        }
+
+        hidden_pids[pid] = {std::move(entry.resource_classes), entry.reason, rate};
+    }
+
+    apply();
+}
+
+QVariantList frame_throttling::throttledClients() const
+{
+    QVariantList result;
+    for (auto const& [pid, data] : hidden_pids) {
+        quint64 held{0};
+        quint64 held_total{0};
+        quint64 released{0};
+        for (auto const& [client, state] : clients) {
+            if (state.pid == pid) {
+                held += std::count_if(state.callbacks.cbegin(),
+                                      state.callbacks.cend(),
+                                      [](auto const& callback) { return callback->done; });
+                held_total += state.held_count;
+                released += state.released_count;
+            }
+        }
+
+        result.append(QVariantMap{
+            {QStringLiteral("pid"), static_cast<qint64>(pid)},
+            {QStringLiteral("resourceClasses"), data.resource_classes},
+            {QStringLiteral("reason"), data.reason},
+            {QStringLiteral("rate"), data.rate},
+            {QStringLiteral("held"), held},
+            {QStringLiteral("heldTotal"), held_total},
+            {QStringLiteral("released"), released},
+        });
+    }
+
+    for (auto const& [client, data] : limited_clients) {
+        auto const& state = clients.at(client);
+        result.append(QVariantMap{
+            {QStringLiteral("pid"), static_cast<qint64>(state.pid)},
+            {QStringLiteral("reason"), data.reason},
+            {QStringLiteral("rate"), data.rate},
+            {QStringLiteral("heldTotal"), static_cast<quint64>(state.held_count)},
+            {QStringLiteral("released"), static_cast<quint64>(state.released_count)},
+        });
+    }
+    return result;
+}
+
+frame_throttling::hidden_client const* frame_throttling::hidden(wl_client* client) const
+{
+    if (auto limited = limited_clients.find(client); limited != limited_clients.end()) {
+        return &limited->second;
+    }
+
+    auto it = clients.find(client);
+    if (it == clients.end()) {
+        return nullptr;
+    }
+
+    auto data = hidden_pids.find(it->second.pid);
+    return data == hidden_pids.end() ? nullptr : &data->second;
+}
+
+frame_throttling::client_state& frame_throttling::get_client(wl_client* client)
+{
+    if (auto it = clients.find(client); it != clients.end()) {
+        return it->second;
+    }
+
+    client_state state;
+    wl_client_get_credentials(client, &state.pid, nullptr, nullptr);
+    state.release_timer = std::make_unique<QTimer>();
+    state.release_timer->setSingleShot(true);
+    QObject::connect(state.release_timer.get(), &QTimer::timeout, this, [this, client] {
+        release(client);
+    });
+
+    auto listener = std::make_unique<client_listener>();
+    listener->listener.notify = &frame_throttling::handle_client_destroyed;
+    listener->throttling = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+    client_listeners.emplace(client, std::move(listener));
+
+    return clients.emplace(client, std::move(state)).first->second;
+}
+
+void frame_throttling::release(wl_client* client)
+{
+    auto it = clients.find(client);
+    if (it == clients.end()) {
+        return;
+    }
+
+    auto& state = it->second;
+    state.release_timer->stop();
+
+    auto const time = monotonic_msec();
+    std::vector<std::unique_ptr<taken_callback>> done;
+    std::erase_if(state.callbacks, [&done](auto& callback) {
+        if (!callback->done) {
+            return false;
+        }
+        done.push_back(std::move(callback));
+        return true;
+    });
+
+    for (auto& callback : done) {
+        if (callback->stand_in) {
+            wl_list_remove(&callback->listener.link);
+            stand_ins.erase(callback->stand_in);
+        }
+        wl_callback_send_done(callback->resource, time);
+        wl_resource_destroy(callback->resource);
+        state.released_count++;
+    }
+}
+
+void frame_throttling::apply()
+{
+    std::vector<wl_client*> shown;
+    for (auto& [client, state] : clients) {
+        auto const has_done = std::any_of(state.callbacks.cbegin(),
+                                          state.callbacks.cend(),
+                                          [](auto const& callback) { return callback->done; });
+        if (!has_done) {
+            continue;
+        }
+
+        auto const data = hidden(client);
+        if (!data) {
+            shown.push_back(client);
+        } else if (data->rate > 0 && !state.release_timer->isActive()) {
+            state.release_timer->start(std::chrono::milliseconds(1000 / data->rate));
+        } else if (data->rate == 0) {
+            state.release_timer->stop();
+        }
+    }
+
+    for (auto client : shown) {
+        release(client);
+    }
+}
+
+void frame_throttling::handle_stand_in_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout taken_callback.
+    auto data = reinterpret_cast<taken_callback*>(listener);
+    auto throttling = data->throttling;
+
+    wl_list_remove(&listener->link);
+    throttling->stand_ins.erase(data->stand_in);
+    data->stand_in = nullptr;
+
+    if (data->done) {
+        // como destroys the callback right after it is done. Ours is destroyed when released.
+        return;
+    }
+
+    // Destroyed without being done, like with its surface. The client's callback goes as well.
+    auto it = throttling->clients.find(wl_resource_get_client(data->resource));
+    if (it == throttling->clients.end()) {
+        return;
+    }
+
+    auto resource = data->resource;
+    std::erase_if(it->second.callbacks,
+                  [data](auto const& callback) { return callback.get() == data; });
+    wl_resource_destroy(resource);
+}
+
+void frame_throttling::handle_client_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout client_listener.
+    auto data = reinterpret_cast<client_listener*>(listener);
+    auto throttling = data->throttling;
+    auto client = data->client;
+
+    wl_list_remove(&listener->link);
+
+    throttling->limited_clients.erase(client);
+
+    // The client's resources are destroyed after this, our callbacks and stand-ins with them.
+    if (auto it = throttling->clients.find(client); it != throttling->clients.end()) {
+        for (auto& callback : it->second.callbacks) {
+            if (callback->stand_in) {
+                wl_list_remove(&callback->listener.link);
+                throttling->stand_ins.erase(callback->stand_in);
+            }
+        }
+        throttling->clients.erase(it);
+    }
+    throttling->client_listeners.erase(client);
+}
+
+}
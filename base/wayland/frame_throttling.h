@@ -0,0 +1,144 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/protocol_observer.h"
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QSocketNotifier>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantList>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <sys/types.h>
+#include <vector>
+
+namespace theseus_ship::base::wayland
+{
+
+struct frame_throttling_config {
+    /// Frame callbacks per second for hidden clients. 0 sends none until they are shown again,
+    /// a negative rate, the default, disables throttling.
+    int hidden_rate{-1};
+
+    /// Rates by resource class overriding the hidden rate. A negative rate disables throttling.
+    std::map<QString, int> rules;
+};
+
+/// Reads the HiddenRate and Rules entries of the FrameThrottling group. Rules are a list of
+/// resource class and rate separated by a colon, like org.mozilla.firefox:0.
+frame_throttling_config load_frame_throttling_config(KConfigGroup const& group);
+
+/**
+ * Throttles frame callbacks of clients whose windows are all minimized, on other virtual desktops
+ * or covered by an opaque window. Such clients would otherwise keep drawing at full rate.
+ *
+ * Visibility lives in como's workspace and is sent by a bundled script through the scripting API.
+ * It is tracked per process, not per surface. A client is throttled only once all windows of its
+ * process are hidden, and then all of its surfaces are. Thumbnails, the overview and screen casts
+ * of such windows update at the throttled rate as well.
+ *
+ * Frame callbacks are sent by como. Only with the KWIN_BUILD_FRAME_THROTTLING build option the
+ * executable interposes wl_resource_create. A frame callback of a hidden client is then handed
+ * to como as a stand-in, created on a private client whose events are discarded. Once como sent
+ * done for the stand-in, the client's callback is done at the configured rate or once the client
+ * is shown again. The throttled clients are readable on D-Bus from the /FrameThrottling object,
+ * which also receives the script's updates.
+ */
+class frame_throttling : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.FrameThrottling")
+
+public:
+    frame_throttling(protocol_observer& observer,
+                     wl_display* display,
+                     frame_throttling_config config);
+    ~frame_throttling() override;
+
+    /// The path of the bundled script.
+    static QString script_path();
+
+    /// The active instance, used by the interposed functions.
+    static frame_throttling* instance();
+
+    /// Whether the frame callback @p id of @p client is created as a stand-in.
+    bool takes_callback(wl_client* client, uint32_t id);
+    /// Hands the client's frame callback @p resource to this. Returns the stand-in como gets
+    /// instead, or nullptr if none could be created.
+    wl_resource* add_callback(wl_resource* resource);
+
+    /// Throttles @p client to @p rate regardless of its visibility, like one flooding the
+    /// compositor. Until unlimit() is called.
+    void limit(wl_client* client, int rate);
+    void unlimit(wl_client* client);
+
+public Q_SLOTS:
+    /// Replaces the visibility of windows with the JSON list @p windows.
+    Q_SCRIPTABLE void update(QString const& windows);
+    /// Per throttled client its pid, resource classes, reason, rate and callback counts.
+    Q_SCRIPTABLE QVariantList throttledClients() const;
+
+private:
+    struct taken_callback {
+        wl_listener listener;
+        frame_throttling* throttling;
+        wl_resource* resource;
+        wl_resource* stand_in;
+        bool done{false};
+    };
+
+    struct hidden_client {
+        QStringList resource_classes;
+        QString reason;
+        int rate{0};
+    };
+
+    struct client_state {
+        std::set<uint32_t> frame_callbacks;
+        std::vector<std::unique_ptr<taken_callback>> callbacks;
+        std::unique_ptr<QTimer> release_timer;
+        pid_t pid{0};
+        uint64_t held_count{0};
+        uint64_t released_count{0};
+    };
+
+    struct client_listener {
+        wl_listener listener;
+        frame_throttling* throttling;
+        wl_client* client;
+    };
+
+    void hold_done(wl_resource* stand_in);
+    hidden_client const* hidden(wl_client* client) const;
+    client_state& get_client(wl_client* client);
+    void release(wl_client* client);
+    void apply();
+
+    static void handle_stand_in_destroyed(wl_listener* listener, void* data);
+    static void handle_client_destroyed(wl_listener* listener, void* data);
+
+    protocol_observer& observer;
+    frame_throttling_config config;
+    std::vector<int> sinks;
+
+    /// Owns the stand-ins. What como sends to them is read and dropped.
+    wl_client* stand_in_client{nullptr};
+    std::unique_ptr<QSocketNotifier> stand_in_notifier;
+    std::map<wl_resource*, wl_client*> stand_ins;
+
+    std::map<pid_t, hidden_client> hidden_pids;
+    std::map<wl_client*, hidden_client> limited_clients;
+    std::map<wl_client*, client_state> clients;
+    std::map<wl_client*, std::unique_ptr<client_listener>> client_listeners;
+};
+
+}
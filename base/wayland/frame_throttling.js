@@ -0,0 +1,95 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Tells the frame throttling which windows are hidden. A window is hidden when it is minimized,
+// not on the current virtual desktop or fully covered by a single opaque window above it.
+
+const service = "org.kde.KWin";
+const path = "/FrameThrottling";
+const iface = "org.kde.kwin.FrameThrottling";
+
+const updateTimer = new QTimer();
+updateTimer.singleShot = true;
+updateTimer.interval = 200;
+
+function isManaged(window) {
+    return (window.normalWindow || window.dialog) && !window.deleted;
+}
+
+function onCurrentDesktop(window) {
+    const current = workspace.currentDesktop;
+    return window.onAllDesktops || window.desktops.some(desktop => desktop === current);
+}
+
+function covers(above, window) {
+    if (above.alpha || above.opacity < 1) {
+        return false;
+    }
+
+    const a = above.frameGeometry;
+    const w = window.frameGeometry;
+    return a.x <= w.x && a.y <= w.y && a.x + a.width >= w.x + w.width
+        && a.y + a.height >= w.y + w.height;
+}
+
+function hiddenReason(window, index, stack) {
+    // Panels, notifications and the like are always visible.
+    if (!isManaged(window)) {
+        return "";
+    }
+    if (window.minimized) {
+        return "minimized";
+    }
+    if (!onCurrentDesktop(window)) {
+        return "desktop";
+    }
+
+    // The stacking order goes from bottom to top.
+    for (let i = index + 1; i < stack.length; ++i) {
+        const above = stack[i];
+        if (isManaged(above) && !above.minimized && onCurrentDesktop(above)
+            && covers(above, window)) {
+            return "occluded";
+        }
+    }
+    return "";
+}
+
+function visibility() {
+    const stack = workspace.stackingOrder.filter(window => !window.deleted);
+    return stack.map((window, index) => ({
+        pid: window.pid,
+        resourceClass: window.resourceClass,
+        reason: hiddenReason(window, index, stack),
+    }));
+}
+
+function scheduleUpdate() {
+    updateTimer.start();
+}
+
+function watch(window) {
+    window.frameGeometryChanged.connect(scheduleUpdate);
+    window.desktopsChanged.connect(scheduleUpdate);
+    window.minimizedChanged.connect(scheduleUpdate);
+    window.opacityChanged.connect(scheduleUpdate);
+}
+
+updateTimer.timeout.connect(() => {
+    callDBus(service, path, iface, "update", JSON.stringify(visibility()));
+});
+
+workspace.windowAdded.connect(window => {
+    watch(window);
+    scheduleUpdate();
+});
+workspace.windowRemoved.connect(scheduleUpdate);
+workspace.windowActivated.connect(scheduleUpdate);
+workspace.currentDesktopChanged.connect(scheduleUpdate);
+workspace.stackingOrderChanged.connect(scheduleUpdate);
+
+workspace.stackingOrder.forEach(watch);
+scheduleUpdate();
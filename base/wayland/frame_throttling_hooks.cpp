@@ -0,0 +1,37 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "frame_throttling.h"
+
+#include <dlfcn.h>
+#include <wayland-server-protocol.h>
+
+// Only built with KWIN_BUILD_FRAME_THROTTLING. This replaces the function of libwayland-server
+// for the whole process. It is exported from the executable through its dynamic list and
+// forwards to libwayland-server.
+extern "C" {
+
+wl_resource*
+wl_resource_create(wl_client* client, wl_interface const* interface, int version, uint32_t id)
+{
+    using namespace theseus_ship::base::wayland;
+    static auto const real = reinterpret_cast<decltype(&wl_resource_create)>(
+        dlsym(RTLD_NEXT, "wl_resource_create"));
+
+    auto throttling = frame_throttling::instance();
+    if (interface != &wl_callback_interface || !id || !throttling
+        || !throttling->takes_callback(client, id)) {
+        return real(client, interface, version, id);
+    }
+
+    auto resource = real(client, interface, version, id);
+    if (!resource) {
+        return nullptr;
+    }
+
+    auto stand_in = throttling->add_callback(resource);
+    return stand_in ? stand_in : resource;
+}
+}
@@ -0,0 +1,89 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "protocol_observer.h"
+
+#include <cstring>
+
+namespace theseus_ship::base::wayland
+{
+
+protocol_observer::protocol_observer(wl_display* display)
+    : logger{wl_display_add_protocol_logger(display, &protocol_observer::log, this)}
+{
+}
+
+protocol_observer::~protocol_observer()
+{
+    if (logger) {
+        wl_protocol_logger_destroy(logger);
+    }
+}
+
+int protocol_observer::add_sink(sink callback)
+{
+    sinks.emplace(next_id, std::move(callback));
+    return next_id++;
+}
+
+int protocol_observer::add_sink(char const* interface, char const* name, sink callback)
+{
+    return add_sink(
+        [interface, name](auto const& message) { return is_message(message, interface, name); },
+        std::move(callback));
+}
+
+int protocol_observer::add_sink(message_filter filter, sink callback)
+{
+    filtered_sinks.emplace(next_id, message_sink{std::move(filter), std::move(callback)});
+    dispatch.clear();
+    return next_id++;
+}
+
+void protocol_observer::remove_sink(int id)
+{
+    sinks.erase(id);
+    if (filtered_sinks.erase(id)) {
+        dispatch.clear();
+    }
+}
+
+bool protocol_observer::is_message(wl_protocol_logger_message const& message,
+                                   char const* interface,
+                                   char const* name)
+{
+    return !strcmp(message.message->name, name)
+        && !strcmp(wl_resource_get_class(message.resource), interface);
+}
+
+void protocol_observer::log(void* data,
+                            wl_protocol_logger_type type,
+                            wl_protocol_logger_message const* msg)
+{
+    auto observer = static_cast<protocol_observer*>(data);
+    for (auto const& [id, sink] : observer->sinks) {
+        sink(type, *msg);
+    }
+    for (auto sink : observer->message_sinks(*msg)) {
+        (*sink)(type, *msg);
+    }
+}
+
+std::vector<protocol_observer::sink const*> const&
+protocol_observer::message_sinks(wl_protocol_logger_message const& message)
+{
+    // A wl_message belongs to a single request or event of one interface.
+    auto [it, inserted] = dispatch.try_emplace(message.message);
+    if (inserted) {
+        for (auto const& [id, filtered] : filtered_sinks) {
+            if (filtered.filter(message)) {
+                it->second.push_back(&filtered.callback);
+            }
+        }
+    }
+    return it->second;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::base::wayland
+{
+
+/**
+ * Observes all requests received from and events sent to clients of a Wayland display. Sinks are
+ * called synchronously while messages are dispatched, so they must be cheap and must not destroy
+ * resources or clients, nor add or remove sinks.
+ *
+ * Sinks for a single request or event should be added with its interface and name, other sinks
+ * with a filter. Which of them a message goes to is resolved once per protocol message and cached
+ * by its wl_message, so all other traffic only costs a lookup instead of matching in every sink.
+ */
+class protocol_observer
+{
+public:
+    using sink = std::function<void(wl_protocol_logger_type, wl_protocol_logger_message const&)>;
+    using message_filter = std::function<bool(wl_protocol_logger_message const&)>;
+
+    explicit protocol_observer(wl_display* display);
+    ~protocol_observer();
+
+    protocol_observer(protocol_observer const&) = delete;
+    protocol_observer& operator=(protocol_observer const&) = delete;
+
+    /// Adds a sink called for all messages.
+    int add_sink(sink callback);
+
+    /// Adds a sink only called for the request or event @p name of objects with @p interface.
+    int add_sink(char const* interface, char const* name, sink callback);
+
+    /// Adds a sink only called for messages @p filter accepts. The filter is only asked once per
+    /// request or event, so it must only look at the wl_message and the resource's interface.
+    int add_sink(message_filter filter, sink callback);
+
+    void remove_sink(int id);
+
+    /// Whether the message is the request or event @p name of an object with @p interface.
+    static bool is_message(wl_protocol_logger_message const& message,
+                           char const* interface,
+                           char const* name);
+
+private:
+    static void log(void* data, wl_protocol_logger_type type, wl_protocol_logger_message const* msg);
+
+    struct message_sink {
+        message_filter filter;
+        sink callback;
+    };
+
+    std::vector<sink const*> const& message_sinks(wl_protocol_logger_message const& message);
+
+    wl_protocol_logger* logger{nullptr};
+    std::map<int, sink> sinks;
+    std::map<int, message_sink> filtered_sinks;
+    std::unordered_map<wl_message const*, std::vector<sink const*>> dispatch;
+    int next_id{0};
+};
+
+}
@@ -0,0 +1,72 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "session_snapshot.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <utility>
+
+namespace theseus_ship::base::wayland
+{
+
+session_snapshot::session_snapshot(QString const& socket_name)
+    : path{QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation)
+           + QStringLiteral("/kwin-session-")
+           + (socket_name.isEmpty() ? QStringLiteral("wayland-0") : socket_name)
+           + QStringLiteral(".json")}
+{
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/SessionSnapshot"), this, QDBusConnection::ExportScriptableContents);
+}
+
+bool session_snapshot::restore()
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "No session snapshot to restore at" << path;
+        return false;
+    }
+
+    auto const data = file.readAll();
+    if (QJsonDocument::fromJson(data).isNull()) {
+        qWarning() << "Ignoring invalid session snapshot at" << path;
+        return false;
+    }
+
+    restored = QString::fromUtf8(data);
+    return true;
+}
+
+QString session_snapshot::script_path()
+{
+    return QStringLiteral(":/theseus-ship/session_snapshot.js");
+}
+
+void session_snapshot::update(QString const& snapshot)
+{
+    // Written to a temporary file first, so a crash never leaves a partial snapshot behind.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open" << path << "for writing the session snapshot.";
+        return;
+    }
+
+    file.write(snapshot.toUtf8());
+    if (!file.commit()) {
+        qWarning() << "Failed to write the session snapshot to" << path;
+    }
+}
+
+QString session_snapshot::pending()
+{
+    return std::exchange(restored, QString());
+}
+
+}
@@ -0,0 +1,48 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+namespace theseus_ship::base::wayland
+{
+
+/**
+ * Keeps a snapshot of window placement, virtual desktops and outputs in a file below
+ * XDG_RUNTIME_DIR, so a restarted compositor can put reconnecting clients back where they were.
+ *
+ * The state lives in como's workspace and is gathered and restored by a bundled script through
+ * the scripting API. The script sends updates to and fetches the snapshot to restore from the
+ * /SessionSnapshot D-Bus object.
+ */
+class session_snapshot : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.SessionSnapshot")
+
+public:
+    /// The snapshot file for the Wayland socket @p socket_name.
+    explicit session_snapshot(QString const& socket_name);
+
+    /// Loads the snapshot from the last run, to be handed out once to the script.
+    bool restore();
+
+    /// The path of the bundled script.
+    static QString script_path();
+
+public Q_SLOTS:
+    /// Replaces the snapshot with the JSON document @p snapshot.
+    Q_SCRIPTABLE void update(QString const& snapshot);
+    /// Returns the snapshot to restore on the first call after restore(), otherwise nothing.
+    Q_SCRIPTABLE QString pending();
+
+private:
+    QString path;
+    QString restored;
+};
+
+}
@@ -0,0 +1,173 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Gathers window placement, virtual desktops and outputs for the session snapshot and on a
+// restart puts reconnecting windows back. Windows are matched by resource class and caption.
+
+const service = "org.kde.KWin";
+const path = "/SessionSnapshot";
+const iface = "org.kde.kwin.SessionSnapshot";
+
+// Windows waiting to be restored, removed once matched.
+let pendingWindows = [];
+
+const updateTimer = new QTimer();
+updateTimer.singleShot = true;
+updateTimer.interval = 500;
+
+function isManaged(window) {
+    return window.normalWindow && !window.deleted;
+}
+
+function relativeGeometry(window) {
+    const geometry = window.frameGeometry;
+    const output = window.output ? window.output.geometry : {x: 0, y: 0};
+    return {
+        x: geometry.x - output.x,
+        y: geometry.y - output.y,
+        width: geometry.width,
+        height: geometry.height,
+    };
+}
+
+function snapshot() {
+    const windows = workspace.stackingOrder.filter(isManaged).map(window => ({
+        resourceClass: window.resourceClass,
+        caption: window.caption,
+        output: window.output ? window.output.name : "",
+        geometry: relativeGeometry(window),
+        desktops: window.desktops.map(desktop => desktop.id),
+        minimized: window.minimized,
+    }));
+
+    return {
+        version: 1,
+        desktops: workspace.desktops.map(desktop => ({id: desktop.id, name: desktop.name})),
+        currentDesktop: workspace.currentDesktop ? workspace.currentDesktop.id : "",
+        outputs: workspace.screens.map(output => ({name: output.name, geometry: output.geometry})),
+        windows: windows,
+    };
+}
+
+function scheduleUpdate() {
+    updateTimer.start();
+}
+
+function watch(window) {
+    if (!isManaged(window)) {
+        return;
+    }
+    window.frameGeometryChanged.connect(scheduleUpdate);
+    window.desktopsChanged.connect(scheduleUpdate);
+    window.minimizedChanged.connect(scheduleUpdate);
+    window.outputChanged.connect(scheduleUpdate);
+    window.captionChanged.connect(scheduleUpdate);
+}
+
+function desktopById(id) {
+    return workspace.desktops.find(desktop => desktop.id === id);
+}
+
+function outputByName(name) {
+    return workspace.screens.find(output => output.name === name);
+}
+
+function takePending(window) {
+    // Prefer an exact match. Captions often change, so fall back to the first of the class.
+    let index = pendingWindows.findIndex(entry => entry.resourceClass === window.resourceClass
+                                         && entry.caption === window.caption);
+    if (index < 0) {
+        index = pendingWindows.findIndex(entry => entry.resourceClass === window.resourceClass);
+    }
+    if (index < 0) {
+        return null;
+    }
+    return pendingWindows.splice(index, 1)[0];
+}
+
+function restoreWindow(window) {
+    if (!isManaged(window) || !pendingWindows.length) {
+        return;
+    }
+
+    const entry = takePending(window);
+    if (!entry) {
+        return;
+    }
+
+    const output = outputByName(entry.output) || workspace.activeScreen;
+    if (window.moveable && window.resizeable) {
+        window.frameGeometry = {
+            x: output.geometry.x + entry.geometry.x,
+            y: output.geometry.y + entry.geometry.y,
+            width: entry.geometry.width,
+            height: entry.geometry.height,
+        };
+    }
+
+    const desktops = entry.desktops.map(desktopById).filter(desktop => desktop);
+    if (desktops.length) {
+        window.desktops = desktops;
+    }
+    window.minimized = entry.minimized;
+}
+
+function restoreDesktops(desktops) {
+    // Desktops are identified by their id, which new desktops do not inherit. Match by position.
+    for (let i = workspace.desktops.length; i < desktops.length; ++i) {
+        workspace.createDesktop(i, desktops[i].name);
+    }
+
+    const ids = {};
+    desktops.forEach((desktop, i) => {
+        if (i < workspace.desktops.length) {
+            ids[desktop.id] = workspace.desktops[i].id;
+        }
+    });
+    return ids;
+}
+
+function restore(data) {
+    if (!data) {
+        return;
+    }
+
+    const state = JSON.parse(data);
+    if (state.version !== 1) {
+        return;
+    }
+
+    const ids = restoreDesktops(state.desktops);
+    const current = desktopById(ids[state.currentDesktop]);
+    if (current) {
+        workspace.currentDesktop = current;
+    }
+
+    pendingWindows = state.windows.map(entry => Object.assign(entry, {
+        desktops: entry.desktops.map(id => ids[id]).filter(id => id),
+    }));
+
+    // Windows that already reconnected before the script ran.
+    workspace.stackingOrder.forEach(restoreWindow);
+}
+
+updateTimer.timeout.connect(() => {
+    callDBus(service, path, iface, "update", JSON.stringify(snapshot()));
+});
+
+workspace.windowAdded.connect(window => {
+    restoreWindow(window);
+    watch(window);
+    scheduleUpdate();
+});
+workspace.windowRemoved.connect(scheduleUpdate);
+workspace.windowActivated.connect(scheduleUpdate);
+workspace.currentDesktopChanged.connect(scheduleUpdate);
+workspace.desktopsChanged.connect(scheduleUpdate);
+workspace.screensChanged.connect(scheduleUpdate);
+
+workspace.stackingOrder.forEach(watch);
+callDBus(service, path, iface, "pending", restore);
@@ -0,0 +1,168 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "socket_activation.h"
+
+#include <QDebug>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+
+namespace theseus_ship::base::wayland
+{
+
+namespace
+{
+
+// The first passed fd as defined by the sd_listen_fds protocol.
+constexpr int listen_fds_start{3};
+
+bool is_listening_unix_socket(int fd)
+{
+    int type{0};
+    int listening{0};
+    socklen_t size{sizeof(int)};
+    if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &size) != 0 || type != SOCK_STREAM) {
+        return false;
+    }
+    size = sizeof(int);
+    if (getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &size) != 0 || !listening) {
+        return false;
+    }
+
+    sockaddr_un address{};
+    size = sizeof(address);
+    return getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) == 0
+        && address.sun_family == AF_UNIX;
+}
+
+std::string socket_path(int fd)
+{
+    sockaddr_un address{};
+    socklen_t size{sizeof(address)};
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size);
+    return address.sun_path;
+}
+
+}
+
+activated_socket::activated_socket(int fd, int lock_fd, std::string name)
+    : fd{fd}
+    , lock_fd{lock_fd}
+    , socket_name{std::move(name)}
+{
+}
+
+activated_socket::~activated_socket()
+{
+    // The fd belongs to the display once added.
+    if (fd >= 0) {
+        close(fd);
+    }
+    close(lock_fd);
+}
+
+std::unique_ptr<activated_socket> activated_socket::take()
+{
+    auto const pid = getenv("LISTEN_PID");
+    auto const count = getenv("LISTEN_FDS");
+    auto const passed = pid && count && atoi(pid) == getpid() && atoi(count) >= 1;
+
+    // Not meant for children, also when the sockets were meant for another process.
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+    unsetenv("LISTEN_FDNAMES");
+
+    if (!passed) {
+        return {};
+    }
+
+    auto const fd = listen_fds_start;
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    if (!is_listening_unix_socket(fd)) {
+        qWarning() << "Ignoring socket passed by systemd, it is no listening Unix stream socket.";
+        close(fd);
+        return {};
+    }
+
+    auto const path = socket_path(fd);
+    auto const runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (!runtime_dir || path.rfind(std::string(runtime_dir) + '/', 0) != 0) {
+        qWarning() << "Ignoring socket passed by systemd, it is not in XDG_RUNTIME_DIR.";
+        close(fd);
+        return {};
+    }
+
+    auto const lock_path = path + ".lock";
+    auto const lock_fd = open(lock_path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0660);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        qWarning() << "Failed to lock" << lock_path.c_str() << ":" << strerror(errno);
+        if (lock_fd >= 0) {
+            close(lock_fd);
+        }
+        close(fd);
+        return {};
+    }
+
+    auto const name = path.substr(strlen(runtime_dir) + 1);
+    return std::unique_ptr<activated_socket>(new activated_socket(fd, lock_fd, name));
+}
+
+std::string const& activated_socket::name() const
+{
+    return socket_name;
+}
+
+bool activated_socket::add_to(wl_display* display)
+{
+    if (wl_display_add_socket_fd(display, fd) != 0) {
+        qWarning() << "Failed to add the socket passed by systemd to the display.";
+        return false;
+    }
+    fd = -1;
+    return true;
+}
+
+void notify_service_manager(char const* state)
+{
+    auto const path = getenv("NOTIFY_SOCKET");
+    if (!path || !path[0]) {
+        return;
+    }
+
+    sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+    auto const length = strlen(path);
+    if (length >= sizeof(address.sun_path)) {
+        return;
+    }
+    memcpy(address.sun_path, path, length);
+
+    // Names starting with @ are in the abstract namespace.
+    if (address.sun_path[0] == '@') {
+        address.sun_path[0] = '\0';
+    }
+
+    auto const fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return;
+    }
+
+    auto const target = reinterpret_cast<sockaddr*>(&address);
+    auto const size = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + length);
+    if (sendto(fd, state, strlen(state), MSG_NOSIGNAL, target, size) < 0) {
+        qWarning() << "Failed to notify the service manager:" << strerror(errno);
+    }
+    close(fd);
+}
+
+}
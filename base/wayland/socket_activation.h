@@ -0,0 +1,50 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <wayland-server-core.h>
+
+namespace theseus_ship::base::wayland
+{
+
+/**
+ * A Wayland listening socket passed by systemd through LISTEN_FDS. Clients can connect to it
+ * before the compositor runs. Their connections queue until the display dispatches them.
+ *
+ * The lock file next to the socket is held, so no other compositor takes over its name.
+ */
+class activated_socket
+{
+public:
+    ~activated_socket();
+
+    /**
+     * Takes the first socket passed by systemd, if it is a listening Unix stream socket. Otherwise
+     * it is closed. The LISTEN_* variables are cleared in any case, so call this before other
+     * threads can read the environment.
+     */
+    static std::unique_ptr<activated_socket> take();
+
+    /// Name of the socket relative to XDG_RUNTIME_DIR, as set in WAYLAND_DISPLAY.
+    std::string const& name() const;
+
+    /// Hands the socket to the display. Returns false on failure.
+    bool add_to(wl_display* display);
+
+private:
+    activated_socket(int fd, int lock_fd, std::string name);
+
+    int fd;
+    int lock_fd;
+    std::string socket_name;
+};
+
+/// Notifies the service manager with @p state, like READY=1. Does nothing without NOTIFY_SOCKET.
+void notify_service_manager(char const* state);
+
+}
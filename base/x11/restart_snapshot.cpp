@@ -0,0 +1,510 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "restart_snapshot.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace theseus_ship::base::x11
+{
+
+namespace
+{
+
+constexpr uint32_t snapshot_magic{0x4b575253};
+constexpr uint32_t snapshot_version{2};
+
+// Coalesces bursts of changes, like when many windows are restacked or moved at once.
+constexpr std::chrono::milliseconds update_delay{100};
+
+// EWMH source indication of pagers, whose requests the window manager always follows.
+constexpr uint32_t source_pager{2};
+
+struct snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t current_desktop;
+    uint32_t active_window;
+    uint32_t window_count;
+    uint32_t focus_count;
+    uint32_t checksum;
+};
+
+template<typename T>
+uint32_t checksum(std::vector<T> const& values, uint32_t sum = 0)
+{
+    auto const bytes = reinterpret_cast<uint8_t const*>(values.data());
+    return std::accumulate(bytes,
+                           bytes + values.size() * sizeof(T),
+                           sum,
+                           [](uint32_t sum, uint8_t byte) { return sum * 31 + byte; });
+}
+
+uint32_t checksum(restart_state const& state)
+{
+    return checksum(state.focus_chain, checksum(state.windows));
+}
+
+template<size_t N>
+std::array<xcb_atom_t, N> intern_atoms(xcb_connection_t* connection,
+                                       std::array<char const*, N> const& names)
+{
+    // Send all requests first so they take a single round trip.
+    std::array<xcb_intern_atom_cookie_t, N> cookies;
+    for (size_t i = 0; i < N; ++i) {
+        cookies[i] = xcb_intern_atom(connection, false, strlen(names[i]), names[i]);
+    }
+
+    std::array<xcb_atom_t, N> atoms;
+    for (size_t i = 0; i < N; ++i) {
+        auto reply = xcb_intern_atom_reply(connection, cookies[i], nullptr);
+        atoms[i] = reply ? reply->atom : XCB_ATOM_NONE;
+        free(reply);
+    }
+    return atoms;
+}
+
+std::optional<uint32_t> read_cardinal(xcb_connection_t* connection,
+                                      xcb_get_property_cookie_t cookie)
+{
+    auto reply = xcb_get_property_reply(connection, cookie, nullptr);
+    if (!reply) {
+        return {};
+    }
+
+    std::optional<uint32_t> value;
+    if (reply->format == 32 && xcb_get_property_value_length(reply) >= 4) {
+        value = *static_cast<uint32_t*>(xcb_get_property_value(reply));
+    }
+    free(reply);
+    return value;
+}
+
+void send_client_message(xcb_connection_t* connection,
+                         xcb_window_t root,
+                         xcb_window_t window,
+                         xcb_atom_t type,
+                         std::array<uint32_t, 5> const& data)
+{
+    xcb_client_message_event_t event{};
+    event.response_type = XCB_CLIENT_MESSAGE;
+    event.format = 32;
+    event.window = window;
+    event.type = type;
+    std::copy(data.begin(), data.end(), event.data.data32);
+
+    xcb_send_event(connection,
+                   false,
+                   root,
+                   XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY,
+                   reinterpret_cast<char const*>(&event));
+}
+
+}
+
+restart_snapshot::restart_snapshot()
+{
+    memfd = memfd_create("kwin-restart-snapshot", MFD_CLOEXEC);
+    if (memfd < 0) {
+        qWarning() << "Failed to create memfd for the restart snapshot:" << strerror(errno);
+        return;
+    }
+
+    int screen_number{0};
+    connection = xcb_connect(nullptr, &screen_number);
+    if (xcb_connection_has_error(connection)) {
+        qWarning() << "Failed to connect to the X server for the restart snapshot.";
+        return;
+    }
+
+    auto screen_it = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screen_number && screen_it.rem; ++i) {
+        xcb_screen_next(&screen_it);
+    }
+    root = screen_it.data->root;
+
+    auto const [client_list_stacking, active_window, current_desktop, wm_desktop]
+        = intern_atoms<4>(connection,
+                          {"_NET_CLIENT_LIST_STACKING",
+                           "_NET_ACTIVE_WINDOW",
+                           "_NET_CURRENT_DESKTOP",
+                           "_NET_WM_DESKTOP"});
+    atoms = {client_list_stacking, active_window, current_desktop, wm_desktop};
+
+    uint32_t const mask[] = {XCB_EVENT_MASK_PROPERTY_CHANGE};
+    xcb_change_window_attributes(connection, root, XCB_CW_EVENT_MASK, mask);
+    xcb_flush(connection);
+
+    update_timer.setSingleShot(true);
+    update_timer.setInterval(update_delay);
+    QObject::connect(&update_timer, &QTimer::timeout, &update_timer, [this] { update(); });
+
+    notifier = std::make_unique<QSocketNotifier>(xcb_get_file_descriptor(connection),
+                                                 QSocketNotifier::Read);
+    QObject::connect(
+        notifier.get(), &QSocketNotifier::activated, notifier.get(), [this] { dispatch(); });
+
+    schedule_update();
+}
+
+restart_snapshot::~restart_snapshot()
+{
+    notifier.reset();
+
+    if (connection) {
+        xcb_disconnect(connection);
+    }
+    if (memfd >= 0) {
+        close(memfd);
+    }
+}
+
+bool restart_snapshot::is_valid() const
+{
+    return notifier != nullptr;
+}
+
+int restart_snapshot::fd() const
+{
+    return memfd;
+}
+
+void restart_snapshot::dispatch()
+{
+    while (auto event = xcb_poll_for_event(connection)) {
+        switch (event->response_type & ~0x80) {
+        case XCB_PROPERTY_NOTIFY: {
+            auto const property = reinterpret_cast<xcb_property_notify_event_t*>(event);
+            if (property->window != root) {
+                if (property->atom == atoms.wm_desktop && windows.count(property->window)) {
+                    dirty.desktops.insert(property->window);
+                    schedule_update();
+                }
+            } else if (property->atom == atoms.client_list_stacking) {
+                dirty.stacking = true;
+                schedule_update();
+            } else if (property->atom == atoms.active_window) {
+                dirty.active_window = true;
+                schedule_update();
+            } else if (property->atom == atoms.current_desktop) {
+                dirty.current_desktop = true;
+                schedule_update();
+            }
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY: {
+            auto const configure = reinterpret_cast<xcb_configure_notify_event_t*>(event);
+            auto it = windows.find(configure->window);
+            if (it == windows.end()) {
+                break;
+            }
+
+            // Only the notifications the window manager sends carry the position on the root
+            // window. Real ones are relative to the frame.
+            if (event->response_type & 0x80) {
+                it->second.x = configure->x;
+                it->second.y = configure->y;
+            }
+            it->second.width = configure->width;
+            it->second.height = configure->height;
+            schedule_update();
+            break;
+        }
+        }
+        free(event);
+    }
+}
+
+void restart_snapshot::schedule_update()
+{
+    if (!update_timer.isActive()) {
+        update_timer.start();
+    }
+}
+
+void restart_snapshot::update()
+{
+    // Send all requests first so there is a single round trip for everything that changed.
+    std::optional<xcb_get_property_cookie_t> stacking_cookie;
+    std::optional<xcb_get_property_cookie_t> active_cookie;
+    std::optional<xcb_get_property_cookie_t> desktop_cookie;
+    std::vector<std::pair<xcb_window_t, xcb_get_property_cookie_t>> desktop_cookies;
+
+    if (dirty.stacking) {
+        stacking_cookie = xcb_get_property(connection,
+                                           false,
+                                           root,
+                                           atoms.client_list_stacking,
+                                           XCB_ATOM_WINDOW,
+                                           0,
+                                           UINT32_MAX / 4);
+    }
+    if (dirty.active_window) {
+        active_cookie = xcb_get_property(
+            connection, false, root, atoms.active_window, XCB_ATOM_WINDOW, 0, 1);
+    }
+    if (dirty.current_desktop) {
+        desktop_cookie = xcb_get_property(
+            connection, false, root, atoms.current_desktop, XCB_ATOM_CARDINAL, 0, 1);
+    }
+    for (auto window : dirty.desktops) {
+        desktop_cookies.emplace_back(
+            window,
+            xcb_get_property(
+                connection, false, window, atoms.wm_desktop, XCB_ATOM_CARDINAL, 0, 1));
+    }
+    dirty = {false, false, false, {}};
+
+    if (desktop_cookie) {
+        current_desktop = read_cardinal(connection, *desktop_cookie).value_or(current_desktop);
+    }
+    if (active_cookie) {
+        active_window = read_cardinal(connection, *active_cookie).value_or(XCB_WINDOW_NONE);
+        if (active_window != XCB_WINDOW_NONE) {
+            std::erase(focus_chain, active_window);
+            focus_chain.push_back(active_window);
+        }
+    }
+    for (auto const& [window, cookie] : desktop_cookies) {
+        auto const desktop = read_cardinal(connection, cookie);
+        if (auto it = windows.find(window); it != windows.end() && desktop) {
+            it->second.desktop = *desktop;
+        }
+    }
+    if (stacking_cookie) {
+        update_stacking(*stacking_cookie);
+    }
+
+    write();
+}
+
+void restart_snapshot::update_stacking(xcb_get_property_cookie_t cookie)
+{
+    auto reply = xcb_get_property_reply(connection, cookie, nullptr);
+    if (!reply) {
+        return;
+    }
+
+    stacking.clear();
+    if (reply->format == 32) {
+        auto const begin = static_cast<xcb_window_t*>(xcb_get_property_value(reply));
+        stacking.assign(begin, begin + xcb_get_property_value_length(reply) / 4);
+    }
+    free(reply);
+
+    std::set<xcb_window_t> const current(stacking.begin(), stacking.end());
+    std::erase_if(windows, [&current](auto const& entry) { return !current.count(entry.first); });
+    std::erase_if(focus_chain, [&current](auto window) { return !current.count(window); });
+
+    std::vector<xcb_window_t> added;
+    for (auto window : stacking) {
+        if (!windows.count(window)) {
+            added.push_back(window);
+        }
+    }
+    add_windows(added);
+}
+
+void restart_snapshot::add_windows(std::vector<xcb_window_t> const& added)
+{
+    struct cookies {
+        xcb_get_property_cookie_t desktop;
+        xcb_get_geometry_cookie_t geometry;
+        xcb_translate_coordinates_cookie_t position;
+    };
+
+    // Changes from here on arrive as events, so the windows are only queried once.
+    uint32_t const mask[] = {XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_PROPERTY_CHANGE};
+
+    std::vector<cookies> pending;
+    pending.reserve(added.size());
+    for (auto window : added) {
+        xcb_change_window_attributes(connection, window, XCB_CW_EVENT_MASK, mask);
+        pending.push_back({
+            xcb_get_property(
+                connection, false, window, atoms.wm_desktop, XCB_ATOM_CARDINAL, 0, 1),
+            xcb_get_geometry(connection, window),
+            xcb_translate_coordinates(connection, window, root, 0, 0),
+        });
+    }
+
+    for (size_t i = 0; i < added.size(); ++i) {
+        auto const desktop = read_cardinal(connection, pending[i].desktop);
+        auto geometry = xcb_get_geometry_reply(connection, pending[i].geometry, nullptr);
+        auto position
+            = xcb_translate_coordinates_reply(connection, pending[i].position, nullptr);
+
+        if (geometry && position) {
+            windows[added[i]] = {
+                .window = added[i],
+                .desktop = desktop.value_or(0),
+                .x = position->dst_x,
+                .y = position->dst_y,
+                .width = geometry->width,
+                .height = geometry->height,
+            };
+        }
+        free(geometry);
+        free(position);
+    }
+}
+
+void restart_snapshot::write()
+{
+    restart_state state;
+    state.current_desktop = current_desktop;
+    state.active_window = active_window;
+    state.focus_chain = focus_chain;
+    for (auto window : stacking) {
+        if (auto it = windows.find(window); it != windows.end()) {
+            state.windows.push_back(it->second);
+        }
+    }
+
+    snapshot_header const header{
+        .magic = snapshot_magic,
+        .version = snapshot_version,
+        .current_desktop = state.current_desktop,
+        .active_window = state.active_window,
+        .window_count = static_cast<uint32_t>(state.windows.size()),
+        .focus_count = static_cast<uint32_t>(state.focus_chain.size()),
+        .checksum = checksum(state),
+    };
+
+    auto const windows_size = state.windows.size() * sizeof(restart_window);
+    auto const focus_size = state.focus_chain.size() * sizeof(xcb_window_t);
+
+    std::vector<char> data(sizeof(header) + windows_size + focus_size);
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), state.windows.data(), windows_size);
+    memcpy(data.data() + sizeof(header) + windows_size, state.focus_chain.data(), focus_size);
+
+    // A crash while writing leaves a snapshot the checksum does not match.
+    if (ftruncate(memfd, data.size()) != 0
+        || pwrite(memfd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+        qWarning() << "Failed to write the restart snapshot:" << strerror(errno);
+    }
+}
+
+std::optional<restart_state> read_restart_state(int fd)
+{
+    snapshot_header header;
+    auto valid = pread(fd, &header, sizeof(header), 0) == sizeof(header)
+        && header.magic == snapshot_magic && header.version == snapshot_version;
+
+    restart_state state;
+    if (valid) {
+        state.current_desktop = header.current_desktop;
+        state.active_window = header.active_window;
+        state.windows.resize(header.window_count);
+        state.focus_chain.resize(header.focus_count);
+
+        auto const windows_size
+            = static_cast<ssize_t>(header.window_count * sizeof(restart_window));
+        auto const focus_size = static_cast<ssize_t>(header.focus_count * sizeof(xcb_window_t));
+        valid = pread(fd, state.windows.data(), windows_size, sizeof(header)) == windows_size
+            && pread(fd, state.focus_chain.data(), focus_size, sizeof(header) + windows_size)
+                == focus_size
+            && checksum(state) == header.checksum;
+    }
+
+    close(fd);
+
+    if (!valid) {
+        qWarning() << "Ignoring invalid restart snapshot.";
+        return {};
+    }
+    return state;
+}
+
+void apply_restart_state(xcb_connection_t* connection,
+                         xcb_window_t root,
+                         restart_state const& state)
+{
+    auto const [restack, move_resize, wm_desktop, current_desktop, active_window]
+        = intern_atoms<5>(connection,
+                          {"_NET_RESTACK_WINDOW",
+                           "_NET_MOVERESIZE_WINDOW",
+                           "_NET_WM_DESKTOP",
+                           "_NET_CURRENT_DESKTOP",
+                           "_NET_ACTIVE_WINDOW"});
+
+    // Static gravity, since the snapshot holds client positions without the frame. Then flags
+    // for x, y, width and height and the source in bits 12-15.
+    constexpr uint32_t move_resize_flags{XCB_GRAVITY_STATIC | (0xf << 8) | (source_pager << 12)};
+
+    // Windows may have been destroyed since the snapshot was taken. Query all of them in one
+    // batch and restore each as its reply arrives, instead of a round trip per window.
+    std::vector<xcb_get_window_attributes_cookie_t> cookies;
+    cookies.reserve(state.windows.size());
+    for (auto const& win : state.windows) {
+        cookies.push_back(xcb_get_window_attributes(connection, win.window));
+    }
+
+    std::vector<xcb_window_t> restored;
+    restored.reserve(state.windows.size());
+
+    for (size_t i = 0; i < state.windows.size(); ++i) {
+        // Errors for destroyed windows are taken here, so they do not end up in the event queue.
+        xcb_generic_error_t* error{nullptr};
+        auto attributes = xcb_get_window_attributes_reply(connection, cookies[i], &error);
+        auto const managed = attributes && !attributes->override_redirect;
+        free(attributes);
+        free(error);
+        if (!managed) {
+            continue;
+        }
+
+        auto const& win = state.windows[i];
+        restored.push_back(win.window);
+        send_client_message(connection, root, win.window, wm_desktop, {win.desktop, source_pager});
+        send_client_message(connection,
+                            root,
+                            win.window,
+                            move_resize,
+                            {move_resize_flags,
+                             static_cast<uint32_t>(win.x),
+                             static_cast<uint32_t>(win.y),
+                             win.width,
+                             win.height});
+    }
+
+    qDebug() << "Restored" << restored.size() << "of" << state.windows.size() << "windows.";
+
+    // Activating raises windows, so the focus chain goes first and the stacking order after.
+    auto const is_restored = [&restored](auto window) {
+        return std::find(restored.begin(), restored.end(), window) != restored.end();
+    };
+    for (auto window : state.focus_chain) {
+        if (is_restored(window)) {
+            send_client_message(connection, root, window, active_window, {source_pager});
+        }
+    }
+    if (state.active_window != XCB_WINDOW_NONE && is_restored(state.active_window)
+        && (state.focus_chain.empty() || state.focus_chain.back() != state.active_window)) {
+        send_client_message(connection, root, state.active_window, active_window, {source_pager});
+    }
+
+    for (size_t i = 1; i < restored.size(); ++i) {
+        send_client_message(connection,
+                            root,
+                            restored[i],
+                            restack,
+                            {source_pager, restored[i - 1], XCB_STACK_MODE_ABOVE});
+    }
+
+    send_client_message(connection, root, root, current_desktop, {state.current_desktop});
+    xcb_flush(connection);
+}
+
+}
@@ -0,0 +1,114 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+#include <xcb/xcb.h>
+
+namespace theseus_ship::base::x11
+{
+
+struct restart_window {
+    xcb_window_t window;
+    uint32_t desktop;
+
+    /// Position of the client window on the root window, without the frame.
+    int16_t x;
+    int16_t y;
+    uint16_t width;
+    uint16_t height;
+};
+
+/// Window management state that survives a restart. Windows are ordered from bottom to top.
+struct restart_state {
+    uint32_t current_desktop{0};
+    xcb_window_t active_window{XCB_WINDOW_NONE};
+    std::vector<restart_window> windows;
+
+    /// Windows in the order they were last active, the least recent first.
+    std::vector<xcb_window_t> focus_chain;
+};
+
+/**
+ * Keeps a snapshot of the stacking order, desktops, geometries, the focus chain and the active
+ * window in a memfd. The state is kept up to date from events on a separate connection. Only
+ * windows new to the stacking order and changed properties are queried, batched into a single
+ * round trip per update. Geometry comes with the configure notify events the window manager
+ * sends to clients when moving them.
+ *
+ * After a crash the memfd is inherited by the replacement instance, so it can restore the state
+ * through EWMH requests once it manages the windows again. Managing them and applying window
+ * rules happens in como on its own, so rule-applied state is established anew from the rules.
+ */
+class restart_snapshot
+{
+public:
+    restart_snapshot();
+    ~restart_snapshot();
+
+    bool is_valid() const;
+
+    /// The memfd holding the last snapshot. It is close-on-exec.
+    int fd() const;
+
+private:
+    void dispatch();
+    void schedule_update();
+    void update();
+    void update_stacking(xcb_get_property_cookie_t cookie);
+    void add_windows(std::vector<xcb_window_t> const& added);
+    void write();
+
+    xcb_connection_t* connection{nullptr};
+    xcb_window_t root{XCB_WINDOW_NONE};
+    int memfd{-1};
+
+    struct {
+        xcb_atom_t client_list_stacking{XCB_ATOM_NONE};
+        xcb_atom_t active_window{XCB_ATOM_NONE};
+        xcb_atom_t current_desktop{XCB_ATOM_NONE};
+        xcb_atom_t wm_desktop{XCB_ATOM_NONE};
+    } atoms;
+
+    uint32_t current_desktop{0};
+    xcb_window_t active_window{XCB_WINDOW_NONE};
+    std::vector<xcb_window_t> stacking;
+    std::map<xcb_window_t, restart_window> windows;
+    std::vector<xcb_window_t> focus_chain;
+
+    struct {
+        bool stacking{true};
+        bool active_window{true};
+        bool current_desktop{true};
+        std::set<xcb_window_t> desktops;
+    } dirty;
+
+    std::unique_ptr<QSocketNotifier> notifier;
+    QTimer update_timer;
+};
+
+/// Reads a state written by restart_snapshot from an inherited fd and closes it.
+std::optional<restart_state> read_restart_state(int fd);
+
+/**
+ * Requests the window manager on @p connection to restore the state like a pager would.
+ *
+ * The windows must already be managed again. Adopting them, with its queries per window, is
+ * done by como's space on its own and is not pipelined from here. Only the queries of the
+ * restore itself are batched.
+ */
+void apply_restart_state(xcb_connection_t* connection,
+                         xcb_window_t root,
+                         restart_state const& state);
+
+}
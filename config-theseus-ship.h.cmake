@@ -4,6 +4,10 @@
     SPDX-License-Identifier: GPL-2.0-or-later
 */
 
+#cmakedefine01 HAVE_LIBCAP
+
+#cmakedefine01 KWIN_BUILD_FRAME_THROTTLING
+
 #cmakedefine01 HAVE_BREEZE_DECO
 #if HAVE_BREEZE_DECO
 #define BREEZE_KDECORATION_PLUGIN_ID "${BREEZE_KDECORATION_PLUGIN_ID}"
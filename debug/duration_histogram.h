@@ -0,0 +1,99 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QVariantList>
+#include <QVariantMap>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Histogram of durations with fixed buckets of 100 microseconds up to 100 milliseconds. Longer
+ * durations are counted in an overflow bucket. Adding a value is a single increment, so it can be
+ * used on hot paths.
+ */
+class duration_histogram
+{
+public:
+    static constexpr std::chrono::microseconds resolution{100};
+    static constexpr size_t bucket_count{1000};
+
+    void add(std::chrono::nanoseconds value)
+    {
+        auto const bucket = static_cast<size_t>(std::max<int64_t>(value / resolution, 0));
+        counts[std::min(bucket, bucket_count)]++;
+        total++;
+        maximum = std::max(maximum, value);
+    }
+
+    void reset()
+    {
+        counts.fill(0);
+        total = 0;
+        maximum = {};
+    }
+
+    uint64_t count() const
+    {
+        return total;
+    }
+
+    /// Upper bound of the bucket holding the value at @p fraction of all values, in microseconds.
+    int64_t percentile(double fraction) const
+    {
+        if (!total) {
+            return 0;
+        }
+
+        auto const target = static_cast<uint64_t>(std::ceil(fraction * total));
+        uint64_t seen{0};
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            seen += counts[bucket];
+            if (seen >= std::max<uint64_t>(target, 1)) {
+                return ((bucket + 1) * resolution).count();
+            }
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(maximum).count();
+    }
+
+    /// Percentiles, maximum and the non-empty buckets as pairs of upper bound and count.
+    QVariantMap to_variant() const
+    {
+        QVariantList buckets;
+        for (size_t bucket = 0; bucket <= bucket_count; ++bucket) {
+            if (counts[bucket]) {
+                buckets.append(QVariantList{
+                    static_cast<qint64>(((bucket + 1) * resolution).count()),
+                    static_cast<quint64>(counts[bucket]),
+                });
+            }
+        }
+
+        return {
+            {QStringLiteral("count"), static_cast<quint64>(total)},
+            {QStringLiteral("p50"), static_cast<qint64>(percentile(0.5))},
+            {QStringLiteral("p95"), static_cast<qint64>(percentile(0.95))},
+            {QStringLiteral("p99"), static_cast<qint64>(percentile(0.99))},
+            {QStringLiteral("max"),
+             static_cast<qint64>(
+                 std::chrono::duration_cast<std::chrono::microseconds>(maximum).count())},
+            {QStringLiteral("buckets"), buckets},
+        };
+    }
+
+private:
+    std::array<uint32_t, bucket_count + 1> counts{};
+    uint64_t total{0};
+    std::chrono::nanoseconds maximum{0};
+};
+
+}
@@ -0,0 +1,81 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "frame_stats.h"
+
+#include "debug/trace.h"
+
+#include <QDBusConnection>
+
+namespace theseus_ship::debug
+{
+
+frame_stats::frame_stats()
+{
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/FrameStats"), this, QDBusConnection::ExportScriptableContents);
+}
+
+void frame_stats::add_frame(QString const& output,
+                            std::optional<std::chrono::nanoseconds> interval)
+{
+    trace::instant(trace_category::render, "frame-presented");
+
+    auto& output_stats = stats[output];
+    output_stats.frames++;
+    if (interval) {
+        output_stats.frame_time.add(*interval);
+    }
+
+    if (!frame_presented) {
+        frame_presented = true;
+        Q_EMIT first_frame_presented();
+    }
+}
+
+void frame_stats::add_missed_vblanks(QString const& output, uint64_t count)
+{
+    stats[output].missed_vblanks += count;
+}
+
+void frame_stats::add_commit_to_present(QString const& output, std::chrono::nanoseconds latency)
+{
+    stats[output].commit_to_present.add(latency);
+}
+
+void frame_stats::add_render_time(QString const& output, std::chrono::nanoseconds duration)
+{
+    stats[output].render_time.add(duration);
+}
+
+std::map<QString, output_frame_stats> const& frame_stats::outputs() const
+{
+    return stats;
+}
+
+QVariantMap frame_stats::statistics() const
+{
+    QVariantMap result;
+    for (auto const& [name, output_stats] : stats) {
+        result.insert(name,
+                      QVariantMap{
+                          {QStringLiteral("frames"), static_cast<quint64>(output_stats.frames)},
+                          {QStringLiteral("missedVblanks"),
+                           static_cast<quint64>(output_stats.missed_vblanks)},
+                          {QStringLiteral("frameTime"), output_stats.frame_time.to_variant()},
+                          {QStringLiteral("commitToPresent"),
+                           output_stats.commit_to_present.to_variant()},
+                          {QStringLiteral("renderTime"), output_stats.render_time.to_variant()},
+                      });
+    }
+    return result;
+}
+
+void frame_stats::reset()
+{
+    stats.clear();
+}
+
+}
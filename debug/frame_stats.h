@@ -0,0 +1,68 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "debug/duration_histogram.h"
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <chrono>
+#include <map>
+#include <optional>
+
+namespace theseus_ship::debug
+{
+
+struct output_frame_stats {
+    uint64_t frames{0};
+    uint64_t missed_vblanks{0};
+
+    /// Time between two consecutive presentations while the output is busy.
+    duration_histogram frame_time;
+
+    /// Time from the compositor committing a frame to the output until it was presented.
+    duration_histogram commit_to_present;
+
+    /// Time from the output asking for a frame until the compositor committed it, which is
+    /// spent rendering. Only tracked on Wayland.
+    duration_histogram render_time;
+};
+
+/**
+ * Collects frame statistics per output. The numbers are fed by a tracker specific to the
+ * windowing system and are readable on D-Bus from the /FrameStats object.
+ */
+class frame_stats : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.FrameStats")
+
+public:
+    frame_stats();
+
+    /// Adds a presented frame. The interval is omitted when the output was idle before.
+    void add_frame(QString const& output, std::optional<std::chrono::nanoseconds> interval);
+    void add_missed_vblanks(QString const& output, uint64_t count);
+    void add_commit_to_present(QString const& output, std::chrono::nanoseconds latency);
+    void add_render_time(QString const& output, std::chrono::nanoseconds duration);
+
+    std::map<QString, output_frame_stats> const& outputs() const;
+
+public Q_SLOTS:
+    /// Per output name a map with the frame and missed vblank counts and the histograms.
+    Q_SCRIPTABLE QVariantMap statistics() const;
+    Q_SCRIPTABLE void reset();
+
+Q_SIGNALS:
+    void first_frame_presented();
+
+private:
+    std::map<QString, output_frame_stats> stats;
+    bool frame_presented{false};
+};
+
+}
@@ -0,0 +1,300 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "input_to_photon.h"
+
+#include <QDBusConnection>
+#include <QFile>
+#include <ctime>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+using protocol_observer = base::wayland::protocol_observer;
+
+// Commits whose frame callback or feedback never arrived, because the surface was destroyed or
+// hidden, are dropped after this. So is input a client did not respond to by then.
+constexpr std::chrono::seconds commit_timeout{5};
+
+// Input older than this when sent is not a response to the user, like replayed key repeats.
+constexpr std::chrono::seconds max_delivery{10};
+
+struct input_message {
+    char const* interface;
+    char const* name;
+    int time_argument;
+};
+
+constexpr input_message input_messages[] = {
+    {"wl_pointer", "motion", 0},
+    {"wl_pointer", "button", 1},
+    {"wl_pointer", "axis", 0},
+    {"wl_keyboard", "key", 1},
+    {"wl_touch", "down", 1},
+    {"wl_touch", "motion", 0},
+};
+
+std::chrono::nanoseconds monotonic_now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+wl_resource* object_resource(wl_argument const& arg)
+{
+    // On the server side objects in arguments are the wl_object of a resource.
+    return reinterpret_cast<wl_resource*>(arg.o);
+}
+
+}
+
+input_to_photon::input_to_photon(protocol_observer& observer)
+    : observer{observer}
+{
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/InputToPhoton"), this, QDBusConnection::ExportScriptableContents);
+}
+
+input_to_photon::~input_to_photon()
+{
+    stop();
+}
+
+void input_to_photon::start()
+{
+    if (isActive()) {
+        return;
+    }
+
+    auto add_sink = [this](char const* interface, char const* name, auto handler) {
+        sinks.push_back(observer.add_sink(
+            interface, name, [handler](auto, auto const& message) { handler(message); }));
+    };
+
+    for (auto const& input : input_messages) {
+        add_sink(input.interface, input.name, [this, input](auto const& message) {
+            handle_input(wl_resource_get_client(message.resource),
+                         message.arguments[input.time_argument].u);
+        });
+    }
+
+    add_sink("wl_surface", "frame", [this](auto const& message) {
+        get_client(wl_resource_get_client(message.resource)).requested[message.arguments[0].n]
+            = {message.resource, false};
+    });
+    add_sink("wp_presentation", "feedback", [this](auto const& message) {
+        get_client(wl_resource_get_client(message.resource)).requested[message.arguments[1].n]
+            = {object_resource(message.arguments[0]), true};
+    });
+    add_sink("wl_surface", "commit", [this](auto const& message) {
+        if (auto it = clients.find(wl_resource_get_client(message.resource));
+            it != clients.end()) {
+            handle_commit(it->second, message.resource);
+        }
+    });
+
+    add_sink("wl_callback", "done", [this](auto const& message) {
+        handle_presented(message.resource, monotonic_now());
+    });
+    add_sink("wp_presentation_feedback", "presented", [this](auto const& message) {
+        auto const args = message.arguments;
+        auto const seconds = (static_cast<uint64_t>(args[0].u) << 32) | args[1].u;
+        handle_presented(message.resource,
+                         std::chrono::seconds(seconds) + std::chrono::nanoseconds(args[2].u));
+    });
+    add_sink("wp_presentation_feedback", "discarded", [this](auto const& message) {
+        if (auto it = clients.find(wl_resource_get_client(message.resource));
+            it != clients.end()) {
+            it->second.waiting.erase(wl_resource_get_id(message.resource));
+        }
+    });
+}
+
+void input_to_photon::stop()
+{
+    for (auto sink : sinks) {
+        observer.remove_sink(sink);
+    }
+    sinks.clear();
+
+    // Requests and events in between are not seen, so the state is stale once started again.
+    for (auto& [client, listener] : client_listeners) {
+        wl_list_remove(&listener->listener.link);
+    }
+    client_listeners.clear();
+    clients.clear();
+}
+
+bool input_to_photon::isActive() const
+{
+    return !sinks.empty();
+}
+
+void input_to_photon::handle_presented(wl_resource* resource, std::chrono::nanoseconds presented)
+{
+    if (auto it = clients.find(wl_resource_get_client(resource)); it != clients.end()) {
+        complete(it->second, wl_resource_get_id(resource), presented);
+    }
+}
+
+void input_to_photon::handle_input(wl_client* client, uint32_t time_msec)
+{
+    auto& state = get_client(client);
+    auto const now = monotonic_now();
+    expire_pending(state, now);
+
+    if (state.pending) {
+        // Only the oldest input the client has not responded to yet is followed.
+        return;
+    }
+
+    auto const now_msec = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+    auto const waited = std::chrono::milliseconds(static_cast<int32_t>(now_msec - time_msec));
+
+    if (waited.count() < 0 || waited > max_delivery) {
+        return;
+    }
+
+    state.pending = pending_input{.input = now - waited, .delivered = now};
+}
+
+void input_to_photon::handle_commit(client_state& state, wl_resource* surface)
+{
+    auto const now = monotonic_now();
+    expire_pending(state, now);
+    std::erase_if(state.waiting, [now](auto const& entry) {
+        return now - entry.second.commit > commit_timeout;
+    });
+
+    // Presentation feedback is exact. Frame callbacks are only used if there is none.
+    auto has_feedback{false};
+    for (auto const& [id, object] : state.requested) {
+        if (object.surface == surface && object.feedback) {
+            has_feedback = true;
+        }
+    }
+
+    auto attributed{false};
+    for (auto it = state.requested.begin(); it != state.requested.end();) {
+        if (it->second.surface != surface) {
+            ++it;
+            continue;
+        }
+        if (state.pending && it->second.feedback == has_feedback) {
+            state.waiting[it->first] = {.input = *state.pending, .commit = now};
+            attributed = true;
+        }
+        it = state.requested.erase(it);
+    }
+
+    // Without a frame callback or feedback there is nothing telling when the commit is shown.
+    // The input is then attributed to a later commit.
+    if (attributed) {
+        state.pending.reset();
+    }
+}
+
+void input_to_photon::expire_pending(client_state& state, std::chrono::nanoseconds now)
+{
+    // A client that ignores input, for example without a visible surface, would otherwise have
+    // its oldest input attributed to a commit much later.
+    if (state.pending && now - state.pending->delivered > commit_timeout) {
+        state.pending.reset();
+    }
+}
+
+void input_to_photon::complete(client_state& state,
+                               uint32_t id,
+                               std::chrono::nanoseconds presented)
+{
+    auto it = state.waiting.find(id);
+    if (it == state.waiting.end()) {
+        return;
+    }
+
+    auto const data = it->second;
+    state.waiting.erase(it);
+
+    // Several feedbacks can be bound to the same commit. Account it once.
+    std::erase_if(state.waiting, [&data](auto const& entry) {
+        return entry.second.commit == data.commit;
+    });
+
+    auto& client_stats = stats[state.command];
+    client_stats.delivery.add(data.input.delivered - data.input.input);
+    client_stats.client.add(data.commit - data.input.delivered);
+    client_stats.presentation.add(presented - data.commit);
+    client_stats.total.add(presented - data.input.input);
+}
+
+input_to_photon::client_state& input_to_photon::get_client(wl_client* client)
+{
+    if (auto it = clients.find(client); it != clients.end()) {
+        return it->second;
+    }
+
+    client_state state;
+    pid_t pid{0};
+    wl_client_get_credentials(client, &pid, nullptr, nullptr);
+
+    QFile comm(QStringLiteral("/proc/%1/comm").arg(pid));
+    if (comm.open(QIODevice::ReadOnly)) {
+        state.command = QString::fromUtf8(comm.readAll()).trimmed();
+    }
+    if (state.command.isEmpty()) {
+        state.command = QStringLiteral("unknown");
+    }
+
+    auto listener = std::make_unique<client_listener>();
+    listener->listener.notify = &input_to_photon::handle_client_destroyed;
+    listener->tracker = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+    client_listeners.emplace(client, std::move(listener));
+
+    return clients.emplace(client, std::move(state)).first->second;
+}
+
+QVariantMap input_to_photon::statistics() const
+{
+    QVariantMap result;
+    for (auto const& [command, client_stats] : stats) {
+        result.insert(command,
+                      QVariantMap{
+                          {QStringLiteral("samples"),
+                           static_cast<quint64>(client_stats.total.count())},
+                          {QStringLiteral("delivery"), client_stats.delivery.to_variant()},
+                          {QStringLiteral("client"), client_stats.client.to_variant()},
+                          {QStringLiteral("presentation"),
+                           client_stats.presentation.to_variant()},
+                          {QStringLiteral("total"), client_stats.total.to_variant()},
+                      });
+    }
+    return result;
+}
+
+void input_to_photon::reset()
+{
+    stats.clear();
+}
+
+void input_to_photon::handle_client_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout client_listener.
+    auto data = reinterpret_cast<client_listener*>(listener);
+    auto tracker = data->tracker;
+    auto client = data->client;
+
+    wl_list_remove(&listener->link);
+    tracker->clients.erase(client);
+    tracker->client_listeners.erase(client);
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/protocol_observer.h"
+#include "debug/duration_histogram.h"
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+struct client_input_latency {
+    /// From the input event's timestamp until it was sent to the client.
+    duration_histogram delivery;
+    /// From sending the event until the client committed a surface.
+    duration_histogram client;
+    /// From the commit until the frame containing it was presented.
+    duration_histogram presentation;
+    /// From the input event's timestamp until presentation.
+    duration_histogram total;
+};
+
+/**
+ * Follows input events sent to Wayland clients until the frame showing the client's response
+ * was presented, split into the time spent in the compositor and in the client.
+ *
+ * The oldest input event a client has not responded to yet is attributed to its next commit.
+ * The commit is presented when the compositor sends presentation feedback for it or, for
+ * clients that did not request feedback, when its frame callback is done. Statistics are kept
+ * per client command and are readable on D-Bus from the /InputToPhoton object.
+ *
+ * Messages are only followed while started, since that costs on every input event and commit.
+ * It is started at launch with the InputToPhoton entry of the Wayland group, or later on D-Bus.
+ */
+class input_to_photon : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.InputToPhoton")
+
+public:
+    explicit input_to_photon(base::wayland::protocol_observer& observer);
+    ~input_to_photon() override;
+
+public Q_SLOTS:
+    /// Starts following messages. Statistics collected before are kept.
+    Q_SCRIPTABLE void start();
+    Q_SCRIPTABLE void stop();
+    Q_SCRIPTABLE bool isActive() const;
+
+    /// Per client command a map with the sample count and the histograms of each stage.
+    Q_SCRIPTABLE QVariantMap statistics() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct pending_input {
+        std::chrono::nanoseconds input;
+        std::chrono::nanoseconds delivered;
+    };
+
+    struct committed_input {
+        pending_input input;
+        std::chrono::nanoseconds commit;
+    };
+
+    struct requested_object {
+        wl_resource* surface;
+        bool feedback;
+    };
+
+    struct client_state {
+        QString command;
+        std::optional<pending_input> pending;
+        /// Frame callbacks and presentation feedback requested since the last commit, by id.
+        std::map<uint32_t, requested_object> requested;
+        /// Frame callbacks or presentation feedback for commits that responded to input.
+        std::map<uint32_t, committed_input> waiting;
+    };
+
+    struct client_listener {
+        wl_listener listener;
+        input_to_photon* tracker;
+        wl_client* client;
+    };
+
+    void handle_input(wl_client* client, uint32_t time_msec);
+    void handle_commit(client_state& state, wl_resource* surface);
+    void expire_pending(client_state& state, std::chrono::nanoseconds now);
+    void handle_presented(wl_resource* resource, std::chrono::nanoseconds presented);
+    void complete(client_state& state, uint32_t id, std::chrono::nanoseconds presented);
+    client_state& get_client(wl_client* client);
+
+    static void handle_client_destroyed(wl_listener* listener, void* data);
+
+    base::wayland::protocol_observer& observer;
+    std::vector<int> sinks;
+
+    std::map<wl_client*, client_state> clients;
+    std::map<wl_client*, std::unique_ptr<client_listener>> client_listeners;
+    std::map<QString, client_input_latency> stats;
+};
+
+}
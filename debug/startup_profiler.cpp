@@ -0,0 +1,224 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "startup_profiler.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+std::chrono::nanoseconds clock_now(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+int64_t resident_set_size()
+{
+    // The second value in statm is the number of resident pages.
+    std::ifstream statm("/proc/self/statm");
+    int64_t size{0};
+    int64_t resident{0};
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+startup_sample take_sample()
+{
+    return {
+        .wall = clock_now(CLOCK_MONOTONIC),
+        .cpu = clock_now(CLOCK_PROCESS_CPUTIME_ID),
+        .rss = resident_set_size(),
+    };
+}
+
+std::chrono::nanoseconds monotonic_process_start()
+{
+    auto const now = clock_now(CLOCK_MONOTONIC);
+
+    std::ifstream stat_file("/proc/self/stat");
+    std::string const content{std::istreambuf_iterator<char>(stat_file), {}};
+
+    // The command name may contain spaces. Parsing starts after it with the state in field 3.
+    auto const comm_end = content.rfind(')');
+    if (comm_end == std::string::npos) {
+        return now;
+    }
+
+    std::istringstream fields(content.substr(comm_end + 1));
+    std::string skipped;
+    for (int field = 3; field < 22; ++field) {
+        fields >> skipped;
+    }
+
+    // Field 22 is the start time of the process in clock ticks since boot.
+    unsigned long long ticks{0};
+    if (!(fields >> ticks)) {
+        return now;
+    }
+
+    auto const since_boot = std::chrono::nanoseconds(
+        static_cast<int64_t>(ticks * 1000000000ull / sysconf(_SC_CLK_TCK)));
+    return now - (clock_now(CLOCK_BOOTTIME) - since_boot);
+}
+
+qint64 to_us(std::chrono::nanoseconds time)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+}
+
+startup_profiler::startup_profiler()
+    : process_start_time{monotonic_process_start()}
+{
+    recorded_marks.push_back({QStringLiteral("main"), clock_now(CLOCK_MONOTONIC)});
+}
+
+void startup_profiler::start_phase(QString const& name)
+{
+    auto const sample = take_sample();
+    end_phase(sample);
+    current = startup_phase{.name = name, .begin = sample, .end = sample};
+    Q_EMIT phase_started(name);
+}
+
+void startup_profiler::mark(QString const& name)
+{
+    recorded_marks.push_back({name, clock_now(CLOCK_MONOTONIC)});
+
+    if (!finished) {
+        return;
+    }
+    if (auto const path = qEnvironmentVariable("KWIN_STARTUP_TRACE"); !path.isEmpty()) {
+        writeTimeline(path);
+    }
+}
+
+void startup_profiler::finish()
+{
+    if (finished) {
+        return;
+    }
+
+    end_phase(take_sample());
+    mark(QStringLiteral("finished"));
+    finished = true;
+
+    qDebug("Startup finished after %lld ms",
+           static_cast<long long>(to_us(recorded_marks.back().time - process_start_time) / 1000));
+
+    if (auto const path = qEnvironmentVariable("KWIN_STARTUP_TRACE"); !path.isEmpty()) {
+        writeTimeline(path);
+    }
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/StartupProfiler"), this, QDBusConnection::ExportScriptableContents);
+    Q_EMIT startup_finished();
+}
+
+bool startup_profiler::is_finished() const
+{
+    return finished;
+}
+
+std::vector<startup_phase> const& startup_profiler::phases() const
+{
+    return finished_phases;
+}
+
+std::vector<startup_mark> const& startup_profiler::marks() const
+{
+    return recorded_marks;
+}
+
+std::chrono::nanoseconds startup_profiler::process_start() const
+{
+    return process_start_time;
+}
+
+QString startup_profiler::timeline() const
+{
+    auto const pid = static_cast<qint64>(getpid());
+    QJsonArray events;
+
+    for (auto const& phase : finished_phases) {
+        events.append(QJsonObject{
+            {QStringLiteral("name"), phase.name},
+            {QStringLiteral("cat"), QStringLiteral("startup")},
+            {QStringLiteral("ph"), QStringLiteral("X")},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), pid},
+            {QStringLiteral("ts"), to_us(phase.begin.wall - process_start_time)},
+            {QStringLiteral("dur"), to_us(phase.end.wall - phase.begin.wall)},
+            {QStringLiteral("args"),
+             QJsonObject{
+                 {QStringLiteral("cpu_us"), to_us(phase.end.cpu - phase.begin.cpu)},
+                 {QStringLiteral("rss_kb"), static_cast<qint64>(phase.end.rss / 1024)},
+                 {QStringLiteral("rss_delta_kb"),
+                  static_cast<qint64>((phase.end.rss - phase.begin.rss) / 1024)},
+             }},
+        });
+    }
+
+    for (auto const& mark : recorded_marks) {
+        events.append(QJsonObject{
+            {QStringLiteral("name"), mark.name},
+            {QStringLiteral("cat"), QStringLiteral("startup")},
+            {QStringLiteral("ph"), QStringLiteral("i")},
+            {QStringLiteral("s"), QStringLiteral("p")},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), pid},
+            {QStringLiteral("ts"), to_us(mark.time - process_start_time)},
+        });
+    }
+
+    QJsonObject const trace{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    return QString::fromUtf8(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+}
+
+bool startup_profiler::writeTimeline(QString const& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open" << path << "for writing the startup trace.";
+        return false;
+    }
+    file.write(timeline().toUtf8());
+    return true;
+}
+
+void startup_profiler::end_phase(startup_sample const& sample)
+{
+    if (!current) {
+        return;
+    }
+
+    current->end = sample;
+    finished_phases.push_back(*current);
+    current.reset();
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+struct startup_sample {
+    std::chrono::nanoseconds wall;
+    std::chrono::nanoseconds cpu;
+    int64_t rss;
+};
+
+struct startup_phase {
+    QString name;
+    startup_sample begin;
+    startup_sample end;
+};
+
+struct startup_mark {
+    QString name;
+    std::chrono::nanoseconds time;
+};
+
+/**
+ * Records the startup of the compositor as a sequence of phases. Each phase spans from its start
+ * until the next phase is started or the profiler is finished. Per phase the monotonic wall time,
+ * the process CPU time and the change of the resident set size are recorded.
+ *
+ * When the environment variable KWIN_STARTUP_TRACE is set to a file path, the timeline is written
+ * to it in Chrome's trace event format once startup has finished. Marks recorded later, like the
+ * first presented frame, rewrite the file. Afterwards the timeline can be retrieved on D-Bus from
+ * the /StartupProfiler object.
+ */
+class startup_profiler : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.StartupProfiler")
+
+public:
+    startup_profiler();
+
+    void start_phase(QString const& name);
+    void mark(QString const& name);
+    void finish();
+
+    bool is_finished() const;
+    std::vector<startup_phase> const& phases() const;
+    std::vector<startup_mark> const& marks() const;
+
+    /// Offset from process start to the monotonic clock origin of all samples.
+    std::chrono::nanoseconds process_start() const;
+
+public Q_SLOTS:
+    /// Returns the recorded timeline as JSON in Chrome's trace event format.
+    Q_SCRIPTABLE QString timeline() const;
+    Q_SCRIPTABLE bool writeTimeline(QString const& path) const;
+
+Q_SIGNALS:
+    void phase_started(QString const& name);
+    void startup_finished();
+
+private:
+    void end_phase(startup_sample const& sample);
+
+    std::chrono::nanoseconds process_start_time;
+    std::optional<startup_phase> current;
+    std::vector<startup_phase> finished_phases;
+    std::vector<startup_mark> recorded_marks;
+    bool finished{false};
+};
+
+}
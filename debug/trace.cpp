@@ -0,0 +1,256 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "trace.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <array>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr size_t buffer_capacity{1 << 16};
+
+struct category_name {
+    trace_category category;
+    char const* name;
+};
+
+constexpr std::array<category_name, 5> category_names{{
+    {trace_category::render, "render"},
+    {trace_category::input, "input"},
+    {trace_category::wayland, "wayland"},
+    {trace_category::x11, "x11"},
+    {trace_category::scripting, "scripting"},
+}};
+
+/**
+ * Ring buffer written by a single thread. The end index is published with release semantics
+ * after an event is stored, so readers acquiring it see all events before it completely.
+ */
+struct thread_buffer {
+    int tid{static_cast<int>(gettid())};
+    std::atomic<uint64_t> end{0};
+    uint64_t start{0};
+    std::vector<trace_event> events = std::vector<trace_event>(buffer_capacity);
+};
+
+struct buffer_registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<thread_buffer>> buffers;
+};
+
+buffer_registry& registry()
+{
+    // Never destroyed, so threads still running at exit can keep writing.
+    static auto instance = new buffer_registry;
+    return *instance;
+}
+
+thread_buffer& local_buffer()
+{
+    thread_local thread_buffer* buffer = [] {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<thread_buffer>());
+        return reg.buffers.back().get();
+    }();
+    return *buffer;
+}
+
+char const* category_to_string(trace_category category)
+{
+    for (auto const& entry : category_names) {
+        if (entry.category == category) {
+            return entry.name;
+        }
+    }
+    return "unknown";
+}
+
+double to_us(std::chrono::nanoseconds time)
+{
+    return time.count() / 1000.;
+}
+
+QJsonObject to_json(trace_event const& event, int tid)
+{
+    auto const name = event.scope ? QString::fromUtf8(event.scope) + QLatin1Char('.')
+                                        + QString::fromUtf8(event.name)
+                                  : QString::fromUtf8(event.name);
+
+    QJsonObject json{
+        {QStringLiteral("name"), name},
+        {QStringLiteral("cat"), QString::fromLatin1(category_to_string(event.category))},
+        {QStringLiteral("ph"), QString(QLatin1Char(event.phase))},
+        {QStringLiteral("pid"), static_cast<qint64>(getpid())},
+        {QStringLiteral("tid"), tid},
+        {QStringLiteral("ts"), to_us(event.time)},
+    };
+
+    if (event.phase == 'X') {
+        json.insert(QStringLiteral("dur"), to_us(event.duration));
+    } else if (event.phase == 'i') {
+        json.insert(QStringLiteral("s"), QStringLiteral("t"));
+    }
+    return json;
+}
+
+}
+
+namespace trace
+{
+
+std::chrono::nanoseconds now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+void record(trace_event const& event)
+{
+    auto& buffer = local_buffer();
+    auto const end = buffer.end.load(std::memory_order_relaxed);
+
+    buffer.events[end % buffer_capacity] = event;
+
+    buffer.end.store(end + 1, std::memory_order_release);
+}
+
+}
+
+tracer::tracer()
+{
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/Tracing"), this, QDBusConnection::ExportScriptableContents);
+
+    if (!qEnvironmentVariableIsSet("KWIN_TRACE")) {
+        return;
+    }
+
+    auto const categories = qEnvironmentVariable("KWIN_TRACE");
+    if (!start(categories)) {
+        qWarning() << "Unknown trace categories in KWIN_TRACE:" << categories;
+    }
+}
+
+tracer::~tracer()
+{
+    if (!isActive()) {
+        return;
+    }
+
+    if (auto const path = qEnvironmentVariable("KWIN_TRACE_FILE"); !path.isEmpty()) {
+        stop(path);
+    } else {
+        trace::enabled_categories = 0;
+    }
+}
+
+bool tracer::start(QString const& categories)
+{
+    uint32_t mask{0};
+    for (auto const& requested : categories.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        auto found = false;
+        for (auto const& entry : category_names) {
+            if (requested.trimmed() == QLatin1String(entry.name)) {
+                mask |= static_cast<uint32_t>(entry.category);
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+
+    if (!mask) {
+        for (auto const& entry : category_names) {
+            mask |= static_cast<uint32_t>(entry.category);
+        }
+    }
+
+    // Events from a previous trace are dropped by moving the start of each buffer.
+    auto& reg = registry();
+    {
+        std::lock_guard lock(reg.mutex);
+        for (auto& buffer : reg.buffers) {
+            buffer->start = buffer->end.load(std::memory_order_acquire);
+        }
+    }
+
+    trace::enabled_categories = mask;
+    Q_EMIT categories_changed();
+    return true;
+}
+
+bool tracer::stop(QString const& path)
+{
+    if (!isActive()) {
+        return false;
+    }
+    trace::enabled_categories = 0;
+    Q_EMIT categories_changed();
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open" << path << "for writing the trace.";
+        return false;
+    }
+
+    QJsonArray events;
+    auto& reg = registry();
+    {
+        std::lock_guard lock(reg.mutex);
+        for (auto const& buffer : reg.buffers) {
+            // Writers that checked for enabled categories before they were cleared may still
+            // store one event at the end, which overwrites the oldest slot of a full buffer.
+            // That slot is skipped, all others up to the end are complete and left alone.
+            auto const end = buffer->end.load(std::memory_order_acquire);
+            auto const oldest = end >= buffer_capacity ? end - buffer_capacity + 1 : 0;
+            auto const begin = std::max(buffer->start, oldest);
+            for (auto index = begin; index < end; ++index) {
+                events.append(to_json(buffer->events[index % buffer_capacity], buffer->tid));
+            }
+        }
+    }
+
+    QJsonObject const trace{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+bool tracer::isActive() const
+{
+    return trace::enabled_categories != 0;
+}
+
+QStringList tracer::availableCategories() const
+{
+    QStringList names;
+    for (auto const& entry : category_names) {
+        names.append(QString::fromLatin1(entry.name));
+    }
+    return names;
+}
+
+}
@@ -0,0 +1,123 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace theseus_ship::debug
+{
+
+enum class trace_category : uint32_t {
+    render = 1 << 0,
+    input = 1 << 1,
+    wayland = 1 << 2,
+    x11 = 1 << 3,
+    scripting = 1 << 4,
+};
+
+/**
+ * A recorded trace event. Names must be string literals or otherwise outlive the trace, like the
+ * interface and message names of Wayland protocols. The scope is prepended to the name.
+ */
+struct trace_event {
+    char const* name;
+    char const* scope;
+    trace_category category;
+    char phase;
+    std::chrono::nanoseconds time;
+    std::chrono::nanoseconds duration;
+};
+
+namespace trace
+{
+
+/// Bitmask of the enabled categories. Checked before recording anything.
+inline std::atomic<uint32_t> enabled_categories{0};
+
+inline bool is_enabled(trace_category category)
+{
+    return enabled_categories.load(std::memory_order_relaxed) & static_cast<uint32_t>(category);
+}
+
+std::chrono::nanoseconds now();
+
+/// Appends to the buffer of the calling thread. Callers check is_enabled beforehand.
+void record(trace_event const& event);
+
+inline void instant(trace_category category, char const* name, char const* scope = nullptr)
+{
+    if (is_enabled(category)) {
+        record({name, scope, category, 'i', now(), {}});
+    }
+}
+
+/// Records a complete event spanning the lifetime of the scope object.
+class scope
+{
+public:
+    scope(trace_category category, char const* name)
+        : category{category}
+        , name{name}
+        , begin{is_enabled(category) ? now() : std::chrono::nanoseconds{}}
+    {
+    }
+
+    ~scope()
+    {
+        if (begin.count() && is_enabled(category)) {
+            record({name, nullptr, category, 'X', begin, now() - begin});
+        }
+    }
+
+    scope(scope const&) = delete;
+    scope& operator=(scope const&) = delete;
+
+private:
+    trace_category category;
+    char const* name;
+    std::chrono::nanoseconds begin;
+};
+
+}
+
+/**
+ * Records trace events in userspace as an alternative to the ftrace markers enabled with
+ * KWIN_PERF_FTRACE, which need a writable tracefs. Every thread writes to its own ring buffer
+ * without locking. When the buffer is full the oldest events are overwritten.
+ *
+ * Tracing is started with a comma-separated list of categories, either at launch through the
+ * environment variable KWIN_TRACE or at runtime on D-Bus from the /Tracing object. Stopping writes
+ * the events in Chrome's trace event format to a file. At exit a running trace is written to the
+ * path in KWIN_TRACE_FILE.
+ */
+class tracer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.Tracing")
+
+public:
+    tracer();
+    ~tracer() override;
+
+public Q_SLOTS:
+    /// Starts with the given categories, all of them when empty. Returns false on unknown ones.
+    Q_SCRIPTABLE bool start(QString const& categories);
+    /// Stops and writes the recorded events to @p path.
+    Q_SCRIPTABLE bool stop(QString const& path);
+    Q_SCRIPTABLE bool isActive() const;
+    Q_SCRIPTABLE QStringList availableCategories() const;
+
+Q_SIGNALS:
+    /// Emitted when tracing starts or stops, for recorders that only hook in while it runs.
+    void categories_changed();
+};
+
+}
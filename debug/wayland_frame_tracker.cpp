@@ -0,0 +1,163 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "wayland_frame_tracker.h"
+
+#include <algorithm>
+#include <ctime>
+
+extern "C" {
+#define WLR_USE_UNSTABLE
+#include <wlr/types/wlr_output.h>
+}
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Longer gaps between frames are considered idle time of the output.
+constexpr std::chrono::seconds idle_gap{1};
+
+std::chrono::nanoseconds monotonic_now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+}
+
+wayland_frame_tracker::wayland_frame_tracker(frame_stats& stats)
+    : stats{stats}
+{
+}
+
+wayland_frame_tracker::~wayland_frame_tracker()
+{
+    for (auto& [native, out] : outputs) {
+        wl_list_remove(&out->frame.listener.link);
+        wl_list_remove(&out->commit.listener.link);
+        wl_list_remove(&out->present.listener.link);
+        wl_list_remove(&out->destroy.listener.link);
+    }
+}
+
+void wayland_frame_tracker::add_output(wlr_output* native)
+{
+    if (outputs.count(native)) {
+        return;
+    }
+
+    auto out = std::make_unique<output>();
+    out->tracker = this;
+    out->native = native;
+    out->name = QString::fromUtf8(native->name);
+
+    auto listen = [&out](output_listener& target, wl_signal& signal, wl_notify_func_t notify) {
+        target.listener.notify = notify;
+        target.data = out.get();
+        wl_signal_add(&signal, &target.listener);
+    };
+    listen(out->commit, native->events.commit, &wayland_frame_tracker::handle_commit);
+    listen(out->present, native->events.present, &wayland_frame_tracker::handle_present);
+    listen(out->destroy, native->events.destroy, &wayland_frame_tracker::handle_destroy);
+
+    // The compositor renders from its own frame listener. Ours goes first to see the start.
+    out->frame.listener.notify = &wayland_frame_tracker::handle_frame;
+    out->frame.data = out.get();
+    wl_list_insert(&native->events.frame.listener_list, &out->frame.listener.link);
+
+    outputs.emplace(native, std::move(out));
+}
+
+void wayland_frame_tracker::process_present(output& out, wlr_output_event_present const& event)
+{
+    auto const commit = out.pending_commit;
+    out.pending_commit.reset();
+
+    if (!event.presented) {
+        return;
+    }
+
+    auto const present
+        = std::chrono::seconds(event.when.tv_sec) + std::chrono::nanoseconds(event.when.tv_nsec);
+    auto const refresh = std::chrono::nanoseconds(event.refresh);
+
+    std::optional<std::chrono::nanoseconds> interval;
+    if (out.last_present && present - *out.last_present < idle_gap) {
+        interval = present - *out.last_present;
+    }
+    stats.add_frame(out.name, interval);
+
+    if (commit) {
+        stats.add_commit_to_present(out.name, present - *commit);
+
+        // Without a known refresh rate, as with adaptive sync, no vblank can be predicted.
+        // A commit before the previous present is due with the vblank right after it.
+        if (out.last_present && refresh.count() > 0) {
+            auto const since_last
+                = std::max(*commit - *out.last_present, std::chrono::nanoseconds::zero());
+            auto const due = 1 + since_last / refresh;
+            auto const took = static_cast<int64_t>(event.seq - out.last_sequence);
+            if (took > due) {
+                stats.add_missed_vblanks(out.name, took - due);
+            }
+        }
+    }
+
+    out.last_present = present;
+    out.last_sequence = event.seq;
+}
+
+void wayland_frame_tracker::handle_frame(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout output_listener.
+    auto out = reinterpret_cast<output_listener*>(listener)->data;
+    out->frame_start = monotonic_now();
+}
+
+void wayland_frame_tracker::handle_commit(wl_listener* listener, void* data)
+{
+    auto out = reinterpret_cast<output_listener*>(listener)->data;
+    auto const event = static_cast<wlr_output_event_commit*>(data);
+
+    // Only commits with a buffer are presented.
+    if (!(event->state->committed & WLR_OUTPUT_STATE_BUFFER)) {
+        return;
+    }
+
+    auto const now = monotonic_now();
+    if (out->frame_start) {
+        out->tracker->stats.add_render_time(out->name, now - *out->frame_start);
+        out->frame_start.reset();
+    }
+
+    // With several commits in flight the oldest determines the latency.
+    if (!out->pending_commit) {
+        out->pending_commit = now;
+    }
+}
+
+void wayland_frame_tracker::handle_present(wl_listener* listener, void* data)
+{
+    auto out = reinterpret_cast<output_listener*>(listener)->data;
+    out->tracker->process_present(*out, *static_cast<wlr_output_event_present*>(data));
+}
+
+void wayland_frame_tracker::handle_destroy(wl_listener* listener, void* /*data*/)
+{
+    auto out = reinterpret_cast<output_listener*>(listener)->data;
+    auto tracker = out->tracker;
+
+    wl_list_remove(&out->frame.listener.link);
+    wl_list_remove(&out->commit.listener.link);
+    wl_list_remove(&out->present.listener.link);
+    wl_list_remove(&out->destroy.listener.link);
+    tracker->outputs.erase(out->native);
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "debug/frame_stats.h"
+
+#include <QString>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <wayland-server-core.h>
+
+struct wlr_output;
+struct wlr_output_event_present;
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Feeds frame statistics from the present events of the backend's outputs. Every frame the
+ * compositor commits to an output is seen, independent of what clients request.
+ *
+ * A frame misses vblanks when it is presented later than the first vblank after its commit. That
+ * vblank is predicted from the sequence and time of the previous present and the refresh rate.
+ *
+ * The render time of a frame lasts from the output's frame event until the commit of a buffer.
+ * Commits changing only the output state, like its mode, are neither rendered nor presented.
+ */
+class wayland_frame_tracker
+{
+public:
+    explicit wayland_frame_tracker(frame_stats& stats);
+    ~wayland_frame_tracker();
+
+    /// Tracks @p native until it is destroyed.
+    void add_output(wlr_output* native);
+
+private:
+    struct output;
+
+    struct output_listener {
+        wl_listener listener;
+        output* data;
+    };
+
+    struct output {
+        wayland_frame_tracker* tracker;
+        wlr_output* native;
+        QString name;
+
+        output_listener frame;
+        output_listener commit;
+        output_listener present;
+        output_listener destroy;
+
+        std::optional<std::chrono::nanoseconds> frame_start;
+        std::optional<std::chrono::nanoseconds> pending_commit;
+        std::optional<std::chrono::nanoseconds> last_present;
+        unsigned last_sequence{0};
+    };
+
+    void process_present(output& out, wlr_output_event_present const& event);
+
+    static void handle_frame(wl_listener* listener, void* data);
+    static void handle_commit(wl_listener* listener, void* data);
+    static void handle_present(wl_listener* listener, void* data);
+    static void handle_destroy(wl_listener* listener, void* data);
+
+    frame_stats& stats;
+    std::map<wlr_output*, std::unique_ptr<output>> outputs;
+};
+
+}
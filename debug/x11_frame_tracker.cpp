@@ -0,0 +1,236 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "x11_frame_tracker.h"
+
+#include "debug/trace.h"
+
+#include <QDebug>
+#include <cstdlib>
+#include <xcb/present.h>
+#include <xcb/randr.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+// Longer gaps between frames are considered idle time of the output.
+constexpr std::chrono::seconds idle_gap{1};
+
+QString output_name_of(xcb_connection_t* connection, xcb_randr_output_t output)
+{
+    auto reply = xcb_randr_get_output_info_reply(
+        connection, xcb_randr_get_output_info(connection, output, XCB_CURRENT_TIME), nullptr);
+    if (!reply) {
+        return {};
+    }
+
+    auto const name = reply->crtc == XCB_NONE
+        ? QString()
+        : QString::fromUtf8(reinterpret_cast<char const*>(xcb_randr_get_output_info_name(reply)),
+                            xcb_randr_get_output_info_name_length(reply));
+    free(reply);
+    return name;
+}
+
+}
+
+x11_frame_tracker::x11_frame_tracker(frame_stats& stats)
+    : stats{stats}
+{
+    int screen_number{0};
+    connection = xcb_connect(nullptr, &screen_number);
+    if (xcb_connection_has_error(connection)) {
+        qWarning() << "Failed to connect to the X server for frame statistics.";
+        return;
+    }
+
+    auto const present = xcb_get_extension_data(connection, &xcb_present_id);
+    if (!present || !present->present) {
+        qWarning() << "X server lacks the Present extension, no frame statistics available.";
+        return;
+    }
+    present_opcode = present->major_opcode;
+    free(xcb_present_query_version_reply(
+        connection,
+        xcb_present_query_version(
+            connection, XCB_PRESENT_MAJOR_VERSION, XCB_PRESENT_MINOR_VERSION),
+        nullptr));
+
+    auto screen_it = xcb_setup_roots_iterator(xcb_get_setup(connection));
+    for (int i = 0; i < screen_number && screen_it.rem; ++i) {
+        xcb_screen_next(&screen_it);
+    }
+    root = screen_it.data->root;
+
+    if (auto const randr = xcb_get_extension_data(connection, &xcb_randr_id);
+        randr && randr->present) {
+        randr_first_event = randr->first_event;
+        xcb_randr_select_input(connection, root, XCB_RANDR_NOTIFY_MASK_SCREEN_CHANGE);
+    }
+    update_output_name();
+    xcb_flush(connection);
+
+    notifier = std::make_unique<QSocketNotifier>(xcb_get_file_descriptor(connection),
+                                                 QSocketNotifier::Read);
+    QObject::connect(
+        notifier.get(), &QSocketNotifier::activated, notifier.get(), [this] { dispatch(); });
+}
+
+x11_frame_tracker::~x11_frame_tracker()
+{
+    notifier.reset();
+    xcb_disconnect(connection);
+}
+
+bool x11_frame_tracker::is_valid() const
+{
+    return notifier != nullptr;
+}
+
+void x11_frame_tracker::set_overlay(xcb_window_t window)
+{
+    if (!notifier || window == overlay) {
+        return;
+    }
+
+    if (overlay != XCB_WINDOW_NONE) {
+        uint32_t const none{XCB_EVENT_MASK_NO_EVENT};
+        xcb_change_window_attributes(connection, overlay, XCB_CW_EVENT_MASK, &none);
+    }
+
+    overlay = window;
+    last_present.reset();
+
+    if (overlay != XCB_WINDOW_NONE) {
+        // Children the compositor creates later are announced through create notify events.
+        uint32_t const substructure{XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY};
+        xcb_change_window_attributes(connection, overlay, XCB_CW_EVENT_MASK, &substructure);
+        select_present(overlay);
+
+        if (auto tree = xcb_query_tree_reply(
+                connection, xcb_query_tree(connection, overlay), nullptr)) {
+            auto const children = xcb_query_tree_children(tree);
+            for (int i = 0; i < xcb_query_tree_children_length(tree); ++i) {
+                select_present(children[i]);
+            }
+            free(tree);
+        }
+    }
+
+    xcb_flush(connection);
+}
+
+void x11_frame_tracker::select_present(xcb_window_t window)
+{
+    xcb_present_select_input(
+        connection, xcb_generate_id(connection), window, XCB_PRESENT_EVENT_MASK_COMPLETE_NOTIFY);
+}
+
+void x11_frame_tracker::update_output_name()
+{
+    output_name = QStringLiteral("unknown");
+    if (!randr_first_event) {
+        return;
+    }
+
+    if (auto primary = xcb_randr_get_output_primary_reply(
+            connection, xcb_randr_get_output_primary(connection, root), nullptr)) {
+        auto const name = output_name_of(connection, primary->output);
+        free(primary);
+        if (!name.isEmpty()) {
+            output_name = name;
+            return;
+        }
+    }
+
+    auto resources = xcb_randr_get_screen_resources_current_reply(
+        connection, xcb_randr_get_screen_resources_current(connection, root), nullptr);
+    if (!resources) {
+        return;
+    }
+
+    auto const crtcs = xcb_randr_get_screen_resources_current_crtcs(resources);
+    uint32_t largest{0};
+    for (int i = 0; i < xcb_randr_get_screen_resources_current_crtcs_length(resources); ++i) {
+        auto crtc = xcb_randr_get_crtc_info_reply(
+            connection,
+            xcb_randr_get_crtc_info(connection, crtcs[i], resources->config_timestamp),
+            nullptr);
+        if (!crtc) {
+            continue;
+        }
+
+        auto const area = static_cast<uint32_t>(crtc->width) * crtc->height;
+        if (area > largest && xcb_randr_get_crtc_info_outputs_length(crtc) > 0) {
+            auto const name
+                = output_name_of(connection, xcb_randr_get_crtc_info_outputs(crtc)[0]);
+            if (!name.isEmpty()) {
+                output_name = name;
+                largest = area;
+            }
+        }
+        free(crtc);
+    }
+    free(resources);
+}
+
+void x11_frame_tracker::dispatch()
+{
+    while (auto event = xcb_poll_for_event(connection)) {
+        auto const type = event->response_type & ~0x80;
+        if (type == XCB_GE_GENERIC) {
+            auto const generic = reinterpret_cast<xcb_ge_generic_event_t const*>(event);
+            if (generic->extension == present_opcode
+                && generic->event_type == XCB_PRESENT_EVENT_COMPLETE_NOTIFY) {
+                handle_complete(event);
+            }
+        } else if (type == XCB_CREATE_NOTIFY) {
+            auto const created = reinterpret_cast<xcb_create_notify_event_t const*>(event);
+            if (created->parent == overlay) {
+                select_present(created->window);
+                xcb_flush(connection);
+            }
+        } else if (randr_first_event
+                   && type == randr_first_event + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
+            update_output_name();
+        }
+        free(event);
+    }
+}
+
+void x11_frame_tracker::handle_complete(xcb_generic_event_t const* event)
+{
+    auto const complete = reinterpret_cast<xcb_present_complete_notify_event_t const*>(event);
+    if (complete->kind != XCB_PRESENT_COMPLETE_KIND_PIXMAP) {
+        return;
+    }
+
+    if (trace::is_enabled(trace_category::x11)) {
+        auto const mode = complete->mode == XCB_PRESENT_COMPLETE_MODE_FLIP ? "flip"
+            : complete->mode == XCB_PRESENT_COMPLETE_MODE_SKIP            ? "skip"
+                                                                          : "copy";
+        trace::instant(trace_category::x11, mode, "present-complete");
+    }
+
+    if (complete->mode == XCB_PRESENT_COMPLETE_MODE_SKIP) {
+        stats.add_missed_vblanks(output_name, 1);
+        return;
+    }
+
+    auto const present = std::chrono::microseconds(complete->ust);
+
+    std::optional<std::chrono::nanoseconds> interval;
+    if (last_present && present - *last_present < idle_gap) {
+        interval = present - *last_present;
+    }
+
+    stats.add_frame(output_name, interval);
+    last_present = present;
+}
+
+}
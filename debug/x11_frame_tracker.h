@@ -0,0 +1,64 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "debug/frame_stats.h"
+
+#include <QSocketNotifier>
+#include <QString>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <xcb/xcb.h>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Feeds frame statistics from the Present extension. A separate X11 connection selects for
+ * completion events on the composite overlay window and its child windows, since the GL backends
+ * present to a child of the overlay.
+ *
+ * The overlay window is the compositor's and only exists while compositing. It is set from the
+ * compositor when compositing starts or stops. The tracker takes no reference of its own, which
+ * would map the overlay above all windows while the compositor does not hold it.
+ *
+ * A single frame covers all outputs. Its presents are synchronized to the output the X server
+ * picks for the window, which is the primary output if set and otherwise the largest one. The
+ * frames are accounted under that output's name.
+ *
+ * Clients do not commit on X11, so there is no commit-to-present latency. Frames the server
+ * had to skip count as missed vblanks.
+ */
+class x11_frame_tracker
+{
+public:
+    x11_frame_tracker(frame_stats& stats);
+    ~x11_frame_tracker();
+
+    bool is_valid() const;
+
+    /// Sets the overlay window frames are presented to. XCB_WINDOW_NONE while not compositing.
+    void set_overlay(xcb_window_t window);
+
+private:
+    void dispatch();
+    void select_present(xcb_window_t window);
+    void update_output_name();
+    void handle_complete(xcb_generic_event_t const* event);
+
+    frame_stats& stats;
+    xcb_connection_t* connection{nullptr};
+    xcb_window_t root{XCB_WINDOW_NONE};
+    xcb_window_t overlay{XCB_WINDOW_NONE};
+    uint8_t present_opcode{0};
+    uint8_t randr_first_event{0};
+    QString output_name;
+    std::unique_ptr<QSocketNotifier> notifier;
+    std::optional<std::chrono::nanoseconds> last_present;
+};
+
+}
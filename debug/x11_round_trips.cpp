@@ -0,0 +1,291 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "x11_round_trips.h"
+
+#include "debug/trace.h"
+
+#include <QDBusConnection>
+#include <QDebug>
+#include <QStringList>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <xcb/xcb.h>
+
+namespace theseus_ship::debug
+{
+
+namespace
+{
+
+constexpr int max_frames{6};
+using frames_t = std::array<void*, max_frames>;
+
+struct site_stats {
+    uint64_t count{0};
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds max{0};
+    std::chrono::nanoseconds first{0};
+    std::chrono::nanoseconds last{0};
+};
+
+struct recorder {
+    std::mutex mutex;
+    std::vector<QString> phases{QStringLiteral("init")};
+    size_t current_phase{0};
+    std::map<std::pair<size_t, frames_t>, site_stats> sites;
+};
+
+recorder& get_recorder()
+{
+    // Never destroyed, libraries may still block on replies while the process exits.
+    static auto instance = new recorder;
+    return *instance;
+}
+
+std::chrono::nanoseconds monotonic_now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+void set_phase(QString const& name)
+{
+    auto& rec = get_recorder();
+    std::lock_guard lock(rec.mutex);
+    rec.phases.push_back(name);
+    rec.current_phase = rec.phases.size() - 1;
+}
+
+void record(frames_t const& frames, std::chrono::nanoseconds begin, std::chrono::nanoseconds end)
+{
+    auto& rec = get_recorder();
+    std::lock_guard lock(rec.mutex);
+
+    auto& stats = rec.sites[{rec.current_phase, frames}];
+    auto const duration = end - begin;
+    if (!stats.count) {
+        stats.first = begin;
+    }
+    stats.count++;
+    stats.total += duration;
+    stats.max = std::max(stats.max, duration);
+    stats.last = begin;
+}
+
+/// Runs @p call and accounts the time it blocked to the calling site.
+template<typename Call>
+[[gnu::always_inline]] inline auto measure(char const* name, Call&& call)
+{
+    // Inlined, so the first frame is the interposed function itself.
+    frames_t frames{};
+    backtrace(frames.data(), max_frames);
+
+    trace::scope trace_scope(trace_category::x11, name);
+    auto const begin = monotonic_now();
+    auto result = call();
+    record(frames, begin, monotonic_now());
+    return result;
+}
+
+template<typename Function>
+Function real_function(char const* name)
+{
+    return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+}
+
+bool is_xcb_frame(Dl_info const& info)
+{
+    return (info.dli_sname && strncmp(info.dli_sname, "xcb_", 4) == 0)
+        || (info.dli_fname && strstr(info.dli_fname, "libxcb"));
+}
+
+QString frame_name(void* address, Dl_info const& info)
+{
+    if (info.dli_sname) {
+        int status{0};
+        auto demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        auto name = QString::fromUtf8(status == 0 ? demangled : info.dli_sname);
+        free(demangled);
+        return name;
+    }
+
+    // Not exported. The full path is kept, so it can be passed to addr2line as is.
+    auto const module = QString::fromUtf8(info.dli_fname ? info.dli_fname : "?");
+    auto const offset = reinterpret_cast<uintptr_t>(address)
+        - reinterpret_cast<uintptr_t>(info.dli_fbase);
+    return module + QStringLiteral("+0x") + QString::number(offset, 16);
+}
+
+/// The first frame outside of libxcb and the interposed functions.
+QString site_name(frames_t const& frames)
+{
+    for (auto address : frames) {
+        if (!address) {
+            break;
+        }
+
+        Dl_info info{};
+        if (!dladdr(address, &info)) {
+            continue;
+        }
+        if (!is_xcb_frame(info)) {
+            return frame_name(address, info);
+        }
+    }
+    return QStringLiteral("unknown");
+}
+
+double to_ms(std::chrono::nanoseconds time)
+{
+    return std::chrono::duration<double, std::milli>(time).count();
+}
+
+}
+
+bool x11_round_trips::is_enabled()
+{
+    static bool const enabled = qEnvironmentVariableIsSet("KWIN_X11_ROUND_TRIPS");
+    return enabled;
+}
+
+x11_round_trips::x11_round_trips(startup_profiler& profiler)
+    : profiler{profiler}
+{
+    connect(&profiler, &startup_profiler::phase_started, this, [](auto const& name) {
+        set_phase(name);
+    });
+    connect(&profiler, &startup_profiler::startup_finished, this, [this] {
+        set_phase(QStringLiteral("running"));
+        for (auto const& line : summary().split(QLatin1Char('\n'), Qt::SkipEmptyParts)) {
+            qDebug().noquote() << line;
+        }
+        QDBusConnection::sessionBus().registerObject(
+            QStringLiteral("/X11RoundTrips"), this, QDBusConnection::ExportScriptableContents);
+    });
+}
+
+QString x11_round_trips::summary() const
+{
+    struct entry {
+        size_t phase;
+        QString site;
+        site_stats stats;
+    };
+
+    std::vector<entry> entries;
+    std::vector<QString> phases;
+    {
+        auto& rec = get_recorder();
+        std::lock_guard lock(rec.mutex);
+        phases = rec.phases;
+
+        // Different stacks can end in the same site. Merge them per phase.
+        std::map<std::pair<size_t, QString>, site_stats> merged;
+        for (auto const& [key, stats] : rec.sites) {
+            auto& target = merged[{key.first, site_name(key.second)}];
+            target.first = target.count ? std::min(target.first, stats.first) : stats.first;
+            target.last = std::max(target.last, stats.last);
+            target.count += stats.count;
+            target.total += stats.total;
+            target.max = std::max(target.max, stats.max);
+        }
+        for (auto const& [key, stats] : merged) {
+            entries.push_back({key.first, key.second, stats});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs.phase != rhs.phase ? lhs.phase < rhs.phase : lhs.stats.total > rhs.stats.total;
+    });
+
+    uint64_t count{0};
+    std::chrono::nanoseconds total{0};
+    for (auto const& entry : entries) {
+        count += entry.stats.count;
+        total += entry.stats.total;
+    }
+
+    auto const start = profiler.process_start();
+    auto text = QString::asprintf("X11 round trips: %llu calls blocked for %.3f ms\n",
+                                  static_cast<unsigned long long>(count),
+                                  to_ms(total));
+    text += QString::asprintf("%-14s %7s %10s %10s %10s %9s  site\n",
+                              "phase",
+                              "calls",
+                              "total ms",
+                              "max ms",
+                              "first ms",
+                              "last ms");
+
+    for (auto const& entry : entries) {
+        text += QString::asprintf("%-14s %7llu %10.3f %10.3f %10.1f %9.1f  ",
+                                  qPrintable(phases.at(entry.phase)),
+                                  static_cast<unsigned long long>(entry.stats.count),
+                                  to_ms(entry.stats.total),
+                                  to_ms(entry.stats.max),
+                                  to_ms(entry.stats.first - start),
+                                  to_ms(entry.stats.last - start));
+        text += entry.site + QLatin1Char('\n');
+    }
+
+    return text;
+}
+
+void x11_round_trips::reset()
+{
+    auto& rec = get_recorder();
+    std::lock_guard lock(rec.mutex);
+    rec.sites.clear();
+}
+
+}
+
+// These replace the functions of libxcb for the whole process. They are exported from the
+// executable through its dynamic list and forward to libxcb.
+extern "C" {
+
+void* xcb_wait_for_reply(xcb_connection_t* c, unsigned int request, xcb_generic_error_t** e)
+{
+    using namespace theseus_ship::debug;
+    static auto const real = real_function<decltype(&xcb_wait_for_reply)>("xcb_wait_for_reply");
+    if (!x11_round_trips::is_enabled()) {
+        return real(c, request, e);
+    }
+    return measure("xcb_wait_for_reply", [&] { return real(c, request, e); });
+}
+
+void* xcb_wait_for_reply64(xcb_connection_t* c, uint64_t request, xcb_generic_error_t** e)
+{
+    using namespace theseus_ship::debug;
+    static auto const real
+        = real_function<decltype(&xcb_wait_for_reply64)>("xcb_wait_for_reply64");
+    if (!x11_round_trips::is_enabled()) {
+        return real(c, request, e);
+    }
+    return measure("xcb_wait_for_reply64", [&] { return real(c, request, e); });
+}
+
+xcb_generic_error_t* xcb_request_check(xcb_connection_t* c, xcb_void_cookie_t cookie)
+{
+    using namespace theseus_ship::debug;
+    static auto const real = real_function<decltype(&xcb_request_check)>("xcb_request_check");
+    if (!x11_round_trips::is_enabled()) {
+        return real(c, cookie);
+    }
+    return measure("xcb_request_check", [&] { return real(c, cookie); });
+}
+}
@@ -0,0 +1,52 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "debug/startup_profiler.h"
+
+#include <QObject>
+#include <QString>
+
+namespace theseus_ship::debug
+{
+
+/**
+ * Profiles calls that block on a reply from the X server. The executable interposes
+ * xcb_wait_for_reply, xcb_wait_for_reply64 and xcb_request_check, so calls from como, Qt and
+ * any other library are seen. Each call is accounted by its call site, which is the first frame
+ * outside of libxcb, and by the startup phase it happened in.
+ *
+ * Only active when the environment variable KWIN_X11_ROUND_TRIPS is set. Otherwise the
+ * interposed functions forward to libxcb right away.
+ *
+ * A summary is logged once startup has finished and can be retrieved on D-Bus from the
+ * /X11RoundTrips object. Calls are also traced in the x11 category.
+ *
+ * Call sites in functions that are not exported, which is most of kwin_x11 and como, are listed
+ * as the module's path and the offset into it. Resolve them with debug info available through
+ * `addr2line -f -C -e <path> <offset>`.
+ */
+class x11_round_trips : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.X11RoundTrips")
+
+public:
+    explicit x11_round_trips(startup_profiler& profiler);
+
+    static bool is_enabled();
+
+public Q_SLOTS:
+    /// Returns a table of all call sites with their count and blocked time, by phase.
+    Q_SCRIPTABLE QString summary() const;
+    /// Drops everything recorded so far.
+    Q_SCRIPTABLE void reset();
+
+private:
+    startup_profiler& profiler;
+};
+
+}
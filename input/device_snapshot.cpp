@@ -0,0 +1,148 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "device_snapshot.h"
+
+#include <QDBusConnection>
+#include <QDBusMetaType>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <chrono>
+
+namespace theseus_ship::input
+{
+
+namespace
+{
+
+// Setting up a device changes several properties at once. Send them in one signal.
+constexpr std::chrono::milliseconds update_delay{50};
+
+QString const manager_path{QStringLiteral("/org/kde/KWin/InputDevice")};
+
+QObject* registered_object(QString const& path)
+{
+    // The device manager and devices are registered on our own connection.
+    return QDBusConnection::sessionBus().objectRegisteredAt(path);
+}
+
+}
+
+device_snapshot::device_snapshot()
+{
+    qDBusRegisterMetaType<QMap<QString, QVariantMap>>();
+
+    update_timer.setSingleShot(true);
+    update_timer.setInterval(update_delay);
+    connect(&update_timer, &QTimer::timeout, this, &device_snapshot::update);
+
+    if (auto manager = registered_object(manager_path)) {
+        connect(manager, SIGNAL(deviceAdded(QString)), this, SLOT(schedule_update()));
+        connect(manager, SIGNAL(deviceRemoved(QString)), this, SLOT(schedule_update()));
+    }
+
+    devices = read_devices();
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/InputDevices"), this, QDBusConnection::ExportScriptableContents);
+}
+
+QMap<QString, QVariantMap> device_snapshot::GetAllDevices()
+{
+    return devices;
+}
+
+void device_snapshot::schedule_update()
+{
+    if (!update_timer.isActive()) {
+        update_timer.start();
+    }
+}
+
+QMap<QString, QVariantMap> device_snapshot::read_devices()
+{
+    auto manager = registered_object(manager_path);
+    if (!manager) {
+        return {};
+    }
+
+    QMap<QString, QVariantMap> result;
+    auto const names = manager->property("devicesSysNames").toStringList();
+
+    for (auto const& name : names) {
+        if (auto device = registered_object(manager_path + QLatin1Char('/') + name)) {
+            result.insert(name, read_device(*device));
+        }
+    }
+
+    return result;
+}
+
+QVariantMap device_snapshot::read_device(QObject& device)
+{
+    static auto const update_slot
+        = staticMetaObject.method(staticMetaObject.indexOfSlot("schedule_update()"));
+
+    QVariantMap properties;
+    auto const meta = device.metaObject();
+
+    // All properties of the device's class are exported, none of QObject's.
+    for (auto i = QObject::staticMetaObject.propertyCount(); i < meta->propertyCount(); ++i) {
+        auto const property = meta->property(i);
+        if (!QDBusMetaType::typeToSignature(property.metaType())) {
+            // Not exported either, it could not be sent.
+            continue;
+        }
+        properties.insert(QString::fromLatin1(property.name()), property.read(&device));
+
+        // Connected once per device. Qt drops the connection when the device goes away.
+        if (property.hasNotifySignal()) {
+            connect(&device, property.notifySignal(), this, update_slot, Qt::UniqueConnection);
+        }
+    }
+
+    return properties;
+}
+
+void device_snapshot::update()
+{
+    update_timer.stop();
+
+    auto current = read_devices();
+    QMap<QString, QVariantMap> changed;
+    QStringList removed;
+
+    for (auto it = current.cbegin(); it != current.cend(); ++it) {
+        auto const previous = devices.constFind(it.key());
+        if (previous == devices.cend()) {
+            changed.insert(it.key(), it.value());
+            continue;
+        }
+
+        QVariantMap changed_properties;
+        for (auto prop = it.value().cbegin(); prop != it.value().cend(); ++prop) {
+            if (previous->value(prop.key()) != prop.value()) {
+                changed_properties.insert(prop.key(), prop.value());
+            }
+        }
+        if (!changed_properties.isEmpty()) {
+            changed.insert(it.key(), changed_properties);
+        }
+    }
+
+    for (auto it = devices.cbegin(); it != devices.cend(); ++it) {
+        if (!current.contains(it.key())) {
+            removed.append(it.key());
+        }
+    }
+
+    devices = std::move(current);
+
+    if (!changed.isEmpty() || !removed.isEmpty()) {
+        Q_EMIT DevicesChanged(changed, removed);
+    }
+}
+
+}
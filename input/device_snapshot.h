@@ -0,0 +1,58 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariantMap>
+
+namespace theseus_ship::input
+{
+
+/**
+ * Provides the properties of all input devices in a single D-Bus call. Reading them from the
+ * device objects of the device manager takes one call per property, which adds up to hundreds of
+ * round trips with many devices.
+ *
+ * The snapshot is read from the device objects registered on our connection directly, without
+ * going through D-Bus. It is refreshed when devices are added or removed and when a device object
+ * emits the notify signal of one of its properties. Calls are served from the snapshot.
+ * Differences to the previous snapshot are sent with the DevicesChanged signal. The object is
+ * /InputDevices.
+ */
+class device_snapshot : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.InputDevices")
+
+public:
+    device_snapshot();
+
+public Q_SLOTS:
+    /// All properties of all devices, by the sys name of the device.
+    Q_SCRIPTABLE QMap<QString, QVariantMap> GetAllDevices();
+
+Q_SIGNALS:
+    /// Added devices with all their properties and changed devices with the changed properties.
+    Q_SCRIPTABLE void DevicesChanged(QMap<QString, QVariantMap> const& changed,
+                                     QStringList const& removed);
+
+private Q_SLOTS:
+    void schedule_update();
+
+private:
+    QMap<QString, QVariantMap> read_devices();
+    QVariantMap read_device(QObject& device);
+    void update();
+
+    QMap<QString, QVariantMap> devices;
+    QTimer update_timer;
+};
+
+}
@@ -0,0 +1,296 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "input/motion_coalescing.h"
+
+#include <como/input/event.h>
+#include <como/input/event_filter.h>
+
+#include <QTimer>
+#include <optional>
+
+namespace theseus_ship::input
+{
+
+/**
+ * Holds back pointer motion and sends it on merged once per frame. Must be the first filter, so
+ * held events skip all others. Any other event sends held motion on first to keep the order.
+ *
+ * Holding motion schedules a frame. The merged motion is sent on when the frame starts, right
+ * before the compositor paints it, so it adds no latency to the frame it ends up in. A timer
+ * sends it on in case no frame starts, for example while all outputs are off.
+ *
+ * Spies see received events and the merged ones.
+ */
+template<typename Redirect>
+class motion_coalescer : public como::input::event_filter<Redirect>
+{
+public:
+    motion_coalescer(Redirect& redirect, motion_coalescing& coalescing)
+        : como::input::event_filter<Redirect>(redirect)
+        , redirect{redirect}
+        , coalescing{coalescing}
+    {
+        timer.setSingleShot(true);
+        timer.setTimerType(Qt::PreciseTimer);
+        QObject::connect(&timer, &QTimer::timeout, &timer, [this] { flush(); });
+        QObject::connect(&coalescing, &motion_coalescing::frame_started, &timer, [this] {
+            flush();
+        });
+    }
+
+    bool motion(como::input::motion_event const& event) override
+    {
+        if (flushing) {
+            return false;
+        }
+
+        coalescing.add_received();
+
+        if (coalescing.wants_full_resolution()) {
+            flush();
+            coalescing.add_delivered(true);
+            return false;
+        }
+
+        if (absolute) {
+            flush();
+        }
+
+        if (relative) {
+            relative->delta += event.delta;
+            relative->unaccel_delta += event.unaccel_delta;
+            relative->base = event.base;
+        } else {
+            relative = event;
+            start();
+        }
+
+        merged++;
+        return true;
+    }
+
+    bool motion_absolute(como::input::motion_absolute_event const& event) override
+    {
+        if (flushing) {
+            return false;
+        }
+
+        coalescing.add_received();
+
+        if (coalescing.wants_full_resolution()) {
+            flush();
+            coalescing.add_delivered(true);
+            return false;
+        }
+
+        if (relative) {
+            flush();
+        }
+
+        // Only the last position matters.
+        if (!absolute) {
+            start();
+        }
+        absolute = event;
+
+        merged++;
+        return true;
+    }
+
+    bool button(como::input::button_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool axis(como::input::axis_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool key(como::input::key_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool touch_down(como::input::touch_down_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool touch_motion(como::input::touch_motion_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool touch_up(como::input::touch_up_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool touch_cancel() override
+    {
+        flush();
+        return false;
+    }
+
+    bool touch_frame() override
+    {
+        flush();
+        return false;
+    }
+
+    bool swipe_begin(como::input::swipe_begin_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool swipe_update(como::input::swipe_update_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool swipe_end(como::input::swipe_end_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool pinch_begin(como::input::pinch_begin_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool pinch_update(como::input::pinch_update_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool pinch_end(como::input::pinch_end_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool hold_begin(como::input::hold_begin_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool hold_end(como::input::hold_end_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool switch_toggle(como::input::switch_toggle_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_tool_axis(como::input::tablet_tool_axis_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_tool_proximity(como::input::tablet_tool_proximity_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_tool_tip(como::input::tablet_tool_tip_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_tool_button(como::input::tablet_tool_button_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_pad_button(como::input::tablet_pad_button_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_pad_strip(como::input::tablet_pad_strip_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+    bool tablet_pad_ring(como::input::tablet_pad_ring_event const& /*event*/) override
+    {
+        flush();
+        return false;
+    }
+
+private:
+    void start()
+    {
+        coalescing.request_frame();
+
+        // Normally the frame starts first. Waiting longer than a frame would add latency.
+        timer.start(std::chrono::duration_cast<std::chrono::milliseconds>(
+            coalescing.frame_interval() * fallback_frames));
+    }
+
+    void flush()
+    {
+        if (!relative && !absolute) {
+            return;
+        }
+
+        timer.stop();
+        flushing = true;
+
+        if (relative) {
+            auto const event = *relative;
+            relative.reset();
+            redirect.pointer->process_motion(event);
+        } else {
+            auto const event = *absolute;
+            absolute.reset();
+            redirect.pointer->process_motion_absolute(event);
+        }
+
+        coalescing.add_delivered(merged == 1);
+        merged = 0;
+        flushing = false;
+    }
+
+    // Outputs that are off start no frames. Held motion is sent on after this many intervals.
+    static constexpr int fallback_frames{2};
+
+    Redirect& redirect;
+    motion_coalescing& coalescing;
+
+    std::optional<como::input::motion_event> relative;
+    std::optional<como::input::motion_absolute_event> absolute;
+    uint64_t merged{0};
+    bool flushing{false};
+    QTimer timer;
+};
+
+}
@@ -0,0 +1,207 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "motion_coalescing.h"
+
+#include <QDBusConnection>
+#include <algorithm>
+
+extern "C" {
+#define WLR_USE_UNSTABLE
+#include <wlr/types/wlr_output.h>
+}
+
+namespace theseus_ship::input
+{
+
+namespace
+{
+
+using protocol_observer = base::wayland::protocol_observer;
+
+// Refresh rates above this are not trusted and would make coalescing pointless.
+constexpr std::chrono::milliseconds min_refresh{2};
+
+}
+
+motion_coalescing_config load_motion_coalescing_config(KConfigGroup const& group)
+{
+    motion_coalescing_config config;
+    config.enabled = group.readEntry("CoalesceMotion", config.enabled);
+    return config;
+}
+
+motion_coalescing::motion_coalescing(protocol_observer& observer)
+    : observer{observer}
+{
+    sinks.push_back(observer.add_sink(
+        "zwp_relative_pointer_manager_v1",
+        "get_relative_pointer",
+        [this](auto, auto const& message) {
+            auto const client = wl_resource_get_client(message.resource);
+            watch_client(client);
+            relative_pointers[client]++;
+        }));
+    sinks.push_back(observer.add_sink(
+        "zwp_relative_pointer_v1", "destroy", [this](auto, auto const& message) {
+            if (auto it = relative_pointers.find(wl_resource_get_client(message.resource));
+                it != relative_pointers.end() && --it->second <= 0) {
+                relative_pointers.erase(it);
+            }
+        }));
+
+    sinks.push_back(observer.add_sink("wl_pointer", "enter", [this](auto, auto const& message) {
+        pointer_focus = wl_resource_get_client(message.resource);
+        watch_client(pointer_focus);
+    }));
+    sinks.push_back(observer.add_sink("wl_pointer", "leave", [this](auto, auto const& message) {
+        if (pointer_focus == wl_resource_get_client(message.resource)) {
+            pointer_focus = nullptr;
+        }
+    }));
+    sinks.push_back(observer.add_sink(
+        "wp_presentation_feedback", "presented", [this](auto, auto const& message) {
+            auto const presented_refresh = std::chrono::nanoseconds(message.arguments[3].u);
+            if (presented_refresh >= min_refresh) {
+                refresh = std::min(refresh, presented_refresh);
+            }
+        }));
+
+    QDBusConnection::sessionBus().registerObject(
+        QStringLiteral("/MotionCoalescing"), this, QDBusConnection::ExportScriptableContents);
+}
+
+motion_coalescing::~motion_coalescing()
+{
+    for (auto sink : sinks) {
+        observer.remove_sink(sink);
+    }
+
+    for (auto& [client, listener] : client_listeners) {
+        wl_list_remove(&listener->listener.link);
+    }
+    for (auto& [native, out] : outputs) {
+        wl_list_remove(&out->frame.listener.link);
+        wl_list_remove(&out->destroy.listener.link);
+    }
+}
+
+bool motion_coalescing::wants_full_resolution() const
+{
+    return pointer_focus && relative_pointers.contains(pointer_focus);
+}
+
+std::chrono::nanoseconds motion_coalescing::frame_interval() const
+{
+    return refresh;
+}
+
+void motion_coalescing::add_received()
+{
+    received++;
+}
+
+void motion_coalescing::add_delivered(bool unchanged)
+{
+    delivered++;
+    if (unchanged) {
+        full_resolution++;
+    }
+}
+
+void motion_coalescing::add_output(wlr_output* native)
+{
+    if (outputs.count(native)) {
+        return;
+    }
+
+    auto out = std::make_unique<output>();
+    out->frame = {{}, this, native};
+    out->frame.listener.notify = &motion_coalescing::handle_frame;
+    out->destroy = {{}, this, native};
+    out->destroy.listener.notify = &motion_coalescing::handle_output_destroyed;
+
+    // Inserted in front of the compositor's own listener, so held motion is sent on before the
+    // frame is painted instead of making it into the next one.
+    wl_list_insert(&native->events.frame.listener_list, &out->frame.listener.link);
+    wl_signal_add(&native->events.destroy, &out->destroy.listener);
+
+    outputs.emplace(native, std::move(out));
+}
+
+void motion_coalescing::request_frame()
+{
+    for (auto const& [native, out] : outputs) {
+        wlr_output_schedule_frame(native);
+    }
+}
+
+QVariantMap motion_coalescing::statistics() const
+{
+    return {
+        {QStringLiteral("received"), static_cast<quint64>(received)},
+        {QStringLiteral("delivered"), static_cast<quint64>(delivered)},
+        {QStringLiteral("fullResolution"), static_cast<quint64>(full_resolution)},
+        {QStringLiteral("frameInterval"),
+         static_cast<qint64>(
+             std::chrono::duration_cast<std::chrono::microseconds>(refresh).count())},
+    };
+}
+
+void motion_coalescing::reset()
+{
+    received = 0;
+    delivered = 0;
+    full_resolution = 0;
+}
+
+void motion_coalescing::watch_client(wl_client* client)
+{
+    if (client_listeners.contains(client)) {
+        return;
+    }
+
+    auto listener = std::make_unique<client_listener>();
+    listener->listener.notify = &motion_coalescing::handle_client_destroyed;
+    listener->coalescing = this;
+    listener->client = client;
+    wl_client_add_destroy_listener(client, &listener->listener);
+    client_listeners.emplace(client, std::move(listener));
+}
+
+void motion_coalescing::handle_client_destroyed(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout client_listener.
+    auto data = reinterpret_cast<client_listener*>(listener);
+    auto coalescing = data->coalescing;
+    auto client = data->client;
+
+    wl_list_remove(&listener->link);
+    if (coalescing->pointer_focus == client) {
+        coalescing->pointer_focus = nullptr;
+    }
+    coalescing->relative_pointers.erase(client);
+    coalescing->client_listeners.erase(client);
+}
+
+void motion_coalescing::handle_frame(wl_listener* listener, void* /*data*/)
+{
+    // The listener is the first member of the standard-layout output_listener.
+    auto data = reinterpret_cast<output_listener*>(listener);
+    Q_EMIT data->coalescing->frame_started();
+}
+
+void motion_coalescing::handle_output_destroyed(wl_listener* listener, void* /*data*/)
+{
+    auto data = reinterpret_cast<output_listener*>(listener);
+    auto coalescing = data->coalescing;
+    auto it = coalescing->outputs.find(data->native);
+
+    wl_list_remove(&it->second->frame.listener.link);
+    wl_list_remove(&it->second->destroy.listener.link);
+    coalescing->outputs.erase(it);
+}
+
+}
@@ -0,0 +1,113 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/protocol_observer.h"
+
+#include <KConfigGroup>
+#include <QObject>
+#include <QVariantMap>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+struct wlr_output;
+
+namespace theseus_ship::input
+{
+
+struct motion_coalescing_config {
+    /// Whether pointer motion is merged to one update per frame.
+    bool enabled{false};
+};
+
+/// Reads the CoalesceMotion entry of the Input group.
+motion_coalescing_config load_motion_coalescing_config(KConfigGroup const& group);
+
+/**
+ * State shared by the motion coalescer with the Wayland side. Pointer motion is merged to one
+ * update per frame, which saves a pass through the filter chain and a client wakeup for every
+ * event of mice polling at up to 8 kHz.
+ *
+ * Clients that bound a relative pointer want every sample, like games aiming with it. While such
+ * a client has pointer focus motion is passed on unchanged. The frame interval is taken from the
+ * fastest refresh seen in presentation feedback. Received and delivered event counts are readable
+ * on D-Bus from the /MotionCoalescing object.
+ *
+ * The frame events of the backend's outputs are the frame start the merged motion is sent on.
+ */
+class motion_coalescing : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.MotionCoalescing")
+
+public:
+    explicit motion_coalescing(base::wayland::protocol_observer& observer);
+    ~motion_coalescing() override;
+
+    /// Whether the client with pointer focus wants every motion event.
+    bool wants_full_resolution() const;
+    std::chrono::nanoseconds frame_interval() const;
+
+    void add_received();
+    /// Adds an event sent on. It is @p unchanged if it was not merged with others.
+    void add_delivered(bool unchanged);
+
+    /// Emits frame_started when @p native starts a frame, until it is destroyed.
+    void add_output(wlr_output* native);
+    /// Schedules a frame on all outputs, so held motion is sent on with the next one.
+    void request_frame();
+
+Q_SIGNALS:
+    /// An output is about to paint a frame.
+    void frame_started();
+
+public Q_SLOTS:
+    /// Counts of received and delivered motion events, and the current frame interval.
+    Q_SCRIPTABLE QVariantMap statistics() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    struct client_listener {
+        wl_listener listener;
+        motion_coalescing* coalescing;
+        wl_client* client;
+    };
+
+    struct output_listener {
+        wl_listener listener;
+        motion_coalescing* coalescing;
+        wlr_output* native;
+    };
+
+    struct output {
+        output_listener frame;
+        output_listener destroy;
+    };
+
+    void watch_client(wl_client* client);
+
+    static void handle_client_destroyed(wl_listener* listener, void* data);
+    static void handle_frame(wl_listener* listener, void* data);
+    static void handle_output_destroyed(wl_listener* listener, void* data);
+
+    base::wayland::protocol_observer& observer;
+    std::vector<int> sinks;
+
+    wl_client* pointer_focus{nullptr};
+    std::map<wl_client*, int> relative_pointers;
+    std::map<wl_client*, std::unique_ptr<client_listener>> client_listeners;
+    std::map<wlr_output*, std::unique_ptr<output>> outputs;
+    std::chrono::nanoseconds refresh{16'666'667};
+
+    uint64_t received{0};
+    uint64_t delivered{0};
+    uint64_t full_resolution{0};
+};
+
+}
@@ -0,0 +1,327 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "record_log.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace theseus_ship::input
+{
+
+namespace
+{
+
+constexpr std::array<char, 8> magic{'K', 'W', 'I', 'N', 'R', 'E', 'C', '2'};
+
+enum class record_type : uint8_t {
+    motion = 1,
+    button,
+    axis,
+    key,
+    commit,
+    motion_absolute,
+    touch,
+    gesture,
+    switch_toggle,
+};
+
+void write_varint(std::ostream& stream, uint64_t value)
+{
+    do {
+        auto byte = static_cast<uint8_t>(value & 0x7f);
+        value >>= 7;
+        if (value) {
+            byte |= 0x80;
+        }
+        stream.put(static_cast<char>(byte));
+    } while (value);
+}
+
+void write_signed(std::ostream& stream, int64_t value)
+{
+    // Zigzag encoding keeps small negative values short.
+    write_varint(stream, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void write_double(std::ostream& stream, double value)
+{
+    static_assert(std::endian::native == std::endian::little);
+    stream.write(reinterpret_cast<char const*>(&value), sizeof(value));
+}
+
+void write_point(std::ostream& stream, QPointF const& point)
+{
+    write_double(stream, point.x());
+    write_double(stream, point.y());
+}
+
+std::optional<uint64_t> read_varint(std::istream& stream)
+{
+    uint64_t value{0};
+    for (int shift = 0; shift < 64; shift += 7) {
+        auto const byte = stream.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return {};
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    return {};
+}
+
+std::optional<int64_t> read_signed(std::istream& stream)
+{
+    auto const value = read_varint(stream);
+    if (!value) {
+        return {};
+    }
+    return static_cast<int64_t>((*value >> 1) ^ (~(*value & 1) + 1));
+}
+
+std::optional<double> read_double(std::istream& stream)
+{
+    double value;
+    if (!stream.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+        return {};
+    }
+    return value;
+}
+
+std::optional<QPointF> read_point(std::istream& stream)
+{
+    auto const x = read_double(stream);
+    auto const y = read_double(stream);
+    if (!x || !y) {
+        return {};
+    }
+    return QPointF(*x, *y);
+}
+
+}
+
+record_writer::record_writer(QString const& path)
+    : file(path.toStdString(), std::ios::binary | std::ios::trunc)
+{
+    file.write(magic.data(), magic.size());
+    file.flush();
+}
+
+bool record_writer::is_open() const
+{
+    return file.good();
+}
+
+void record_writer::write(recorded_event const& event)
+{
+    std::visit(
+        [this, &event](auto const& data) {
+            using type = std::decay_t<decltype(data)>;
+
+            // Commits are stamped on arrival, which may be before input stamped by the device.
+            auto write_header = [&](record_type record) {
+                file.put(static_cast<char>(record));
+                write_signed(file, (event.time - last).count());
+                last = event.time;
+            };
+
+            if constexpr (std::is_same_v<type, recorded_motion>) {
+                write_header(record_type::motion);
+                write_point(file, data.delta);
+                write_point(file, data.unaccel_delta);
+            } else if constexpr (std::is_same_v<type, recorded_motion_absolute>) {
+                write_header(record_type::motion_absolute);
+                write_point(file, data.pos);
+            } else if constexpr (std::is_same_v<type, recorded_button>) {
+                write_header(record_type::button);
+                write_varint(file, data.key);
+                file.put(data.pressed);
+            } else if constexpr (std::is_same_v<type, recorded_axis>) {
+                write_header(record_type::axis);
+                file.put(static_cast<char>(data.source));
+                file.put(static_cast<char>(data.orientation));
+                write_double(file, data.delta);
+                write_signed(file, data.delta_discrete);
+            } else if constexpr (std::is_same_v<type, recorded_key>) {
+                write_header(record_type::key);
+                write_varint(file, data.keycode);
+                file.put(data.pressed);
+            } else if constexpr (std::is_same_v<type, recorded_touch>) {
+                write_header(record_type::touch);
+                file.put(static_cast<char>(data.type));
+                write_signed(file, data.id);
+                write_point(file, data.pos);
+            } else if constexpr (std::is_same_v<type, recorded_gesture>) {
+                write_header(record_type::gesture);
+                file.put(static_cast<char>(data.type));
+                write_varint(file, data.fingers);
+                write_point(file, data.delta);
+                write_double(file, data.scale);
+                write_double(file, data.rotation);
+                file.put(data.cancelled);
+            } else if constexpr (std::is_same_v<type, recorded_switch>) {
+                write_header(record_type::switch_toggle);
+                file.put(static_cast<char>(data.type));
+                file.put(data.on);
+            } else if constexpr (std::is_same_v<type, recorded_commit>) {
+                write_header(record_type::commit);
+                write_varint(file, data.client);
+                write_varint(file, data.surface);
+            }
+        },
+        event.data);
+
+    file.flush();
+}
+
+std::chrono::milliseconds record_writer::since_first(uint32_t time_msec)
+{
+    if (!first) {
+        first = time_msec;
+    }
+
+    // Timestamps are 32 bit and wrap around after 49 days. The difference stays correct.
+    return std::chrono::milliseconds(static_cast<int32_t>(time_msec - *first));
+}
+
+record_reader::record_reader(QString const& path)
+    : file(path.toStdString(), std::ios::binary)
+{
+    std::array<char, magic.size()> header;
+    valid = file.read(header.data(), header.size()) && header == magic;
+}
+
+bool record_reader::is_valid() const
+{
+    return valid;
+}
+
+std::optional<recorded_event> record_reader::next()
+{
+    if (!valid) {
+        return {};
+    }
+
+    auto const type = file.get();
+    auto const time_delta = read_signed(file);
+    if (type == std::char_traits<char>::eof() || !time_delta) {
+        return {};
+    }
+
+    last += std::chrono::milliseconds(*time_delta);
+    recorded_event event{.time = last, .data = {}};
+
+    switch (static_cast<record_type>(type)) {
+    case record_type::motion: {
+        auto const delta = read_point(file);
+        auto const unaccel_delta = read_point(file);
+        if (!delta || !unaccel_delta) {
+            return {};
+        }
+        event.data = recorded_motion{.delta = *delta, .unaccel_delta = *unaccel_delta};
+        return event;
+    }
+    case record_type::motion_absolute: {
+        auto const pos = read_point(file);
+        if (!pos) {
+            return {};
+        }
+        event.data = recorded_motion_absolute{.pos = *pos};
+        return event;
+    }
+    case record_type::button: {
+        auto const key = read_varint(file);
+        auto const pressed = file.get();
+        if (!key || pressed == std::char_traits<char>::eof()) {
+            return {};
+        }
+        event.data = recorded_button{.key = static_cast<uint32_t>(*key), .pressed = pressed != 0};
+        return event;
+    }
+    case record_type::axis: {
+        auto const source = file.get();
+        auto const orientation = file.get();
+        auto const delta = read_double(file);
+        auto const discrete = read_signed(file);
+        if (orientation == std::char_traits<char>::eof() || !delta || !discrete) {
+            return {};
+        }
+        event.data = recorded_axis{.source = static_cast<uint8_t>(source),
+                                   .orientation = static_cast<uint8_t>(orientation),
+                                   .delta = *delta,
+                                   .delta_discrete = static_cast<int32_t>(*discrete)};
+        return event;
+    }
+    case record_type::key: {
+        auto const keycode = read_varint(file);
+        auto const pressed = file.get();
+        if (!keycode || pressed == std::char_traits<char>::eof()) {
+            return {};
+        }
+        event.data
+            = recorded_key{.keycode = static_cast<uint32_t>(*keycode), .pressed = pressed != 0};
+        return event;
+    }
+    case record_type::touch: {
+        auto const touch_type = file.get();
+        auto const id = read_signed(file);
+        auto const pos = read_point(file);
+        if (touch_type == std::char_traits<char>::eof() || !id || !pos) {
+            return {};
+        }
+        event.data = recorded_touch{.type = static_cast<recorded_touch_type>(touch_type),
+                                    .id = static_cast<int32_t>(*id),
+                                    .pos = *pos};
+        return event;
+    }
+    case record_type::gesture: {
+        auto const gesture_type = file.get();
+        auto const fingers = read_varint(file);
+        auto const delta = read_point(file);
+        auto const scale = read_double(file);
+        auto const rotation = read_double(file);
+        auto const cancelled = file.get();
+        if (gesture_type == std::char_traits<char>::eof() || !fingers || !delta || !scale
+            || !rotation || cancelled == std::char_traits<char>::eof()) {
+            return {};
+        }
+        event.data = recorded_gesture{.type = static_cast<recorded_gesture_type>(gesture_type),
+                                      .fingers = static_cast<uint32_t>(*fingers),
+                                      .delta = *delta,
+                                      .scale = *scale,
+                                      .rotation = *rotation,
+                                      .cancelled = cancelled != 0};
+        return event;
+    }
+    case record_type::switch_toggle: {
+        auto const switch_type = file.get();
+        auto const on = file.get();
+        if (on == std::char_traits<char>::eof()) {
+            return {};
+        }
+        event.data = recorded_switch{.type = static_cast<uint8_t>(switch_type), .on = on != 0};
+        return event;
+    }
+    case record_type::commit: {
+        auto const client = read_varint(file);
+        auto const surface = read_varint(file);
+        if (!client || !surface) {
+            return {};
+        }
+        event.data = recorded_commit{.client = static_cast<uint32_t>(*client),
+                                     .surface = static_cast<uint32_t>(*surface)};
+        return event;
+    }
+    }
+
+    // Unknown record types can't be skipped since their size is not known.
+    valid = false;
+    return {};
+}
+
+}
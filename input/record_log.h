@@ -0,0 +1,151 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QPointF>
+#include <QString>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <variant>
+
+namespace theseus_ship::input
+{
+
+struct recorded_motion {
+    QPointF delta;
+    QPointF unaccel_delta;
+};
+
+struct recorded_motion_absolute {
+    QPointF pos;
+};
+
+struct recorded_button {
+    uint32_t key;
+    bool pressed;
+};
+
+struct recorded_axis {
+    uint8_t source;
+    uint8_t orientation;
+    double delta;
+    int32_t delta_discrete;
+};
+
+struct recorded_key {
+    uint32_t keycode;
+    bool pressed;
+};
+
+enum class recorded_touch_type : uint8_t {
+    down,
+    motion,
+    up,
+    cancel,
+    frame,
+};
+
+struct recorded_touch {
+    recorded_touch_type type;
+    int32_t id;
+    QPointF pos;
+};
+
+enum class recorded_gesture_type : uint8_t {
+    swipe_begin,
+    swipe_update,
+    swipe_end,
+    pinch_begin,
+    pinch_update,
+    pinch_end,
+    hold_begin,
+    hold_end,
+};
+
+/// Fields not carried by the gesture's type are left at their defaults.
+struct recorded_gesture {
+    recorded_gesture_type type;
+    uint32_t fingers{0};
+    QPointF delta;
+    double scale{1.};
+    double rotation{0.};
+    bool cancelled{false};
+};
+
+struct recorded_switch {
+    uint8_t type;
+    bool on;
+};
+
+/// A surface commit of a client. Only recorded for analysis, replays skip it.
+struct recorded_commit {
+    uint32_t client;
+    uint32_t surface;
+};
+
+struct recorded_event {
+    /// Time since the first record, taken from the event's own timestamp.
+    std::chrono::milliseconds time;
+    std::variant<recorded_motion,
+                 recorded_motion_absolute,
+                 recorded_button,
+                 recorded_axis,
+                 recorded_key,
+                 recorded_touch,
+                 recorded_gesture,
+                 recorded_switch,
+                 recorded_commit>
+        data;
+};
+
+/**
+ * Writes input events to a compact binary log. Each record consists of a type byte, the time
+ * since the previous record in milliseconds and the payload. Integers are stored as LEB128
+ * variable length quantities, floating point values as little-endian doubles.
+ *
+ * Times are the events' own CLOCK_MONOTONIC timestamps in milliseconds, as libinput provides
+ * them. Records are flushed one by one, so a crash does not lose the tail of the recording.
+ */
+class record_writer
+{
+public:
+    explicit record_writer(QString const& path);
+
+    bool is_open() const;
+
+    template<typename Data>
+    void write(Data const& data, uint32_t time_msec)
+    {
+        write({.time = since_first(time_msec), .data = data});
+    }
+
+    void write(recorded_event const& event);
+
+private:
+    std::chrono::milliseconds since_first(uint32_t time_msec);
+
+    std::ofstream file;
+    std::optional<uint32_t> first;
+    std::chrono::milliseconds last{0};
+};
+
+class record_reader
+{
+public:
+    explicit record_reader(QString const& path);
+
+    bool is_valid() const;
+    std::optional<recorded_event> next();
+
+private:
+    std::ifstream file;
+    std::chrono::milliseconds last{0};
+    bool valid{false};
+};
+
+}
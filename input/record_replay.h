@@ -0,0 +1,449 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/wayland/protocol_observer.h"
+#include "input/record_log.h"
+
+#include <como/input/event.h>
+#include <como/input/event_spy.h>
+#include <como/input/platform.h>
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <ctime>
+#include <memory>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace theseus_ship::input
+{
+
+/**
+ * Records input events as they are received by the input redirect, with their own timestamps,
+ * together with the surface commits of all clients. Tablet events are not recorded.
+ */
+template<typename Redirect>
+class input_recorder : public como::input::event_spy<Redirect>
+{
+public:
+    input_recorder(Redirect& redirect,
+                   base::wayland::protocol_observer& observer,
+                   std::unique_ptr<record_writer> writer)
+        : como::input::event_spy<Redirect>(redirect)
+        , observer{observer}
+        , writer{std::move(writer)}
+    {
+        sink = observer.add_sink("wl_surface", "commit", [this](auto, auto const& message) {
+            record_commit(message.resource);
+        });
+    }
+
+    ~input_recorder() override
+    {
+        observer.remove_sink(sink);
+    }
+
+    void motion(como::input::motion_event const& event) override
+    {
+        writer->write(recorded_motion{.delta = event.delta, .unaccel_delta = event.unaccel_delta},
+                      event.base.time_msec);
+    }
+
+    void motion_absolute(como::input::motion_absolute_event const& event) override
+    {
+        writer->write(recorded_motion_absolute{.pos = event.pos}, event.base.time_msec);
+    }
+
+    void button(como::input::button_event const& event) override
+    {
+        writer->write(
+            recorded_button{
+                .key = event.key,
+                .pressed = event.state == como::input::button_state::pressed,
+            },
+            event.base.time_msec);
+    }
+
+    void axis(como::input::axis_event const& event) override
+    {
+        writer->write(
+            recorded_axis{
+                .source = static_cast<uint8_t>(event.source),
+                .orientation = static_cast<uint8_t>(event.orientation),
+                .delta = event.delta,
+                .delta_discrete = event.delta_discrete,
+            },
+            event.base.time_msec);
+    }
+
+    void key(como::input::key_event const& event) override
+    {
+        writer->write(
+            recorded_key{
+                .keycode = event.keycode,
+                .pressed = event.state == como::input::key_state::pressed,
+            },
+            event.base.time_msec);
+    }
+
+    void touch_down(como::input::touch_down_event const& event) override
+    {
+        writer->write(
+            recorded_touch{.type = recorded_touch_type::down, .id = event.id, .pos = event.pos},
+            event.base.time_msec);
+    }
+
+    void touch_motion(como::input::touch_motion_event const& event) override
+    {
+        writer->write(
+            recorded_touch{.type = recorded_touch_type::motion, .id = event.id, .pos = event.pos},
+            event.base.time_msec);
+    }
+
+    void touch_up(como::input::touch_up_event const& event) override
+    {
+        writer->write(recorded_touch{.type = recorded_touch_type::up, .id = event.id, .pos = {}},
+                      event.base.time_msec);
+    }
+
+    // Cancel and frame carry no timestamp. They follow the touch events they belong to.
+    void touch_cancel() override
+    {
+        writer->write(recorded_touch{.type = recorded_touch_type::cancel, .id = 0, .pos = {}},
+                      monotonic_msec());
+    }
+
+    void touch_frame() override
+    {
+        writer->write(recorded_touch{.type = recorded_touch_type::frame, .id = 0, .pos = {}},
+                      monotonic_msec());
+    }
+
+    void swipe_begin(como::input::swipe_begin_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::swipe_begin, .fingers = event.fingers},
+            event.base.time_msec);
+    }
+
+    void swipe_update(como::input::swipe_update_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::swipe_update, .delta = event.delta},
+            event.base.time_msec);
+    }
+
+    void swipe_end(como::input::swipe_end_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::swipe_end,
+                             .cancelled = event.cancelled},
+            event.base.time_msec);
+    }
+
+    void pinch_begin(como::input::pinch_begin_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::pinch_begin, .fingers = event.fingers},
+            event.base.time_msec);
+    }
+
+    void pinch_update(como::input::pinch_update_event const& event) override
+    {
+        writer->write(recorded_gesture{.type = recorded_gesture_type::pinch_update,
+                                       .delta = event.delta,
+                                       .scale = event.scale,
+                                       .rotation = event.rotation},
+                      event.base.time_msec);
+    }
+
+    void pinch_end(como::input::pinch_end_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::pinch_end,
+                             .cancelled = event.cancelled},
+            event.base.time_msec);
+    }
+
+    void hold_begin(como::input::hold_begin_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::hold_begin, .fingers = event.fingers},
+            event.base.time_msec);
+    }
+
+    void hold_end(como::input::hold_end_event const& event) override
+    {
+        writer->write(
+            recorded_gesture{.type = recorded_gesture_type::hold_end,
+                             .cancelled = event.cancelled},
+            event.base.time_msec);
+    }
+
+    void switch_toggle(como::input::switch_toggle_event const& event) override
+    {
+        writer->write(
+            recorded_switch{
+                .type = static_cast<uint8_t>(event.type),
+                .on = event.state == como::input::switch_state::on,
+            },
+            event.base.time_msec);
+    }
+
+private:
+    /// Same clock as the timestamps libinput puts on events.
+    static uint32_t monotonic_msec()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint32_t>(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+    }
+
+    void record_commit(wl_resource* surface)
+    {
+        pid_t pid{0};
+        wl_client_get_credentials(wl_resource_get_client(surface), &pid, nullptr, nullptr);
+        writer->write(
+            recorded_commit{
+                .client = static_cast<uint32_t>(pid),
+                .surface = wl_resource_get_id(surface),
+            },
+            monotonic_msec());
+    }
+
+    base::wayland::protocol_observer& observer;
+    std::unique_ptr<record_writer> writer;
+    int sink;
+};
+
+/**
+ * Feeds recorded events back into the input redirect. Meant to be used with virtual outputs, so
+ * no real devices interfere. Recorded commits are skipped.
+ *
+ * Each event is due at the replay start plus its recorded time and carries exactly that as its
+ * timestamp, so replays of a recording see the same event times. Deadlines are absolute on
+ * CLOCK_MONOTONIC and do not drift with the time spent injecting. Events due together are
+ * injected in one go in their recorded order. Injected events come from devices of the replay's
+ * own, which are added to the input platform for its lifetime.
+ */
+template<typename Redirect>
+class input_replay
+{
+public:
+    input_replay(Redirect& redirect, std::unique_ptr<record_reader> reader)
+        : redirect{redirect}
+        , reader{std::move(reader)}
+        , timer_fd{timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)}
+    {
+        como::input::platform_add_pointer(redirect.platform, &pointer);
+        como::input::platform_add_keyboard(redirect.platform, &keyboard);
+        como::input::platform_add_touch(redirect.platform, &touch);
+        como::input::platform_add_switch(redirect.platform, &switch_device);
+
+        notifier = std::make_unique<QSocketNotifier>(timer_fd, QSocketNotifier::Read);
+        QObject::connect(notifier.get(), &QSocketNotifier::activated, notifier.get(), [this] {
+            uint64_t expirations;
+            [[maybe_unused]] auto const ret = read(timer_fd, &expirations, sizeof(expirations));
+            replay_due();
+        });
+    }
+
+    ~input_replay()
+    {
+        notifier.reset();
+        close(timer_fd);
+
+        // The platform must not keep pointers to the devices of a destroyed replay.
+        como::input::platform_remove_switch(redirect.platform, &switch_device);
+        como::input::platform_remove_touch(redirect.platform, &touch);
+        como::input::platform_remove_keyboard(redirect.platform, &keyboard);
+        como::input::platform_remove_pointer(redirect.platform, &pointer);
+    }
+
+    void start()
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start_time);
+        pending = reader->next();
+        schedule();
+    }
+
+private:
+    std::chrono::nanoseconds elapsed() const
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return std::chrono::seconds(now.tv_sec - start_time.tv_sec)
+            + std::chrono::nanoseconds(now.tv_nsec - start_time.tv_nsec);
+    }
+
+    void schedule()
+    {
+        if (!pending) {
+            qInfo("Input replay finished after %lld ms.",
+                  static_cast<long long>(
+                      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed()).count()));
+            return;
+        }
+
+        auto const due = std::chrono::nanoseconds(pending->time);
+        auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(due);
+
+        itimerspec spec{};
+        spec.it_value.tv_sec = start_time.tv_sec + seconds.count();
+        spec.it_value.tv_nsec = start_time.tv_nsec + (due - seconds).count();
+        if (spec.it_value.tv_nsec >= 1000000000) {
+            spec.it_value.tv_sec++;
+            spec.it_value.tv_nsec -= 1000000000;
+        }
+
+        // Deadlines in the past expire right away.
+        timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    void replay_due()
+    {
+        auto const now = elapsed();
+        while (pending && pending->time <= now) {
+            inject(*pending);
+            pending = reader->next();
+        }
+        schedule();
+    }
+
+    void inject(recorded_event const& event)
+    {
+        auto const time = static_cast<uint32_t>(
+            start_time.tv_sec * 1000 + start_time.tv_nsec / 1000000 + event.time.count());
+
+        std::visit(
+            [&](auto const& data) {
+                using type = std::decay_t<decltype(data)>;
+
+                if constexpr (std::is_same_v<type, recorded_motion>) {
+                    redirect.pointer->process_motion({
+                        .delta = data.delta,
+                        .unaccel_delta = data.unaccel_delta,
+                        .base = {&pointer, time},
+                    });
+                } else if constexpr (std::is_same_v<type, recorded_motion_absolute>) {
+                    redirect.pointer->process_motion_absolute({
+                        .pos = data.pos,
+                        .base = {&pointer, time},
+                    });
+                } else if constexpr (std::is_same_v<type, recorded_button>) {
+                    redirect.pointer->process_button({
+                        .key = data.key,
+                        .state = data.pressed ? como::input::button_state::pressed
+                                              : como::input::button_state::released,
+                        .base = {&pointer, time},
+                    });
+                } else if constexpr (std::is_same_v<type, recorded_axis>) {
+                    redirect.pointer->process_axis({
+                        .source = static_cast<como::input::axis_source>(data.source),
+                        .orientation = static_cast<como::input::axis_orientation>(data.orientation),
+                        .delta = data.delta,
+                        .delta_discrete = data.delta_discrete,
+                        .base = {&pointer, time},
+                    });
+                } else if constexpr (std::is_same_v<type, recorded_key>) {
+                    redirect.keyboard->process_key({
+                        .keycode = data.keycode,
+                        .state = data.pressed ? como::input::key_state::pressed
+                                              : como::input::key_state::released,
+                        .requires_modifier_update = true,
+                        .base = {&keyboard, time},
+                    });
+                } else if constexpr (std::is_same_v<type, recorded_touch>) {
+                    inject_touch(data, time);
+                } else if constexpr (std::is_same_v<type, recorded_gesture>) {
+                    inject_gesture(data, time);
+                } else if constexpr (std::is_same_v<type, recorded_switch>) {
+                    redirect.process_switch_toggle({
+                        .type = static_cast<como::input::switch_type>(data.type),
+                        .state = data.on ? como::input::switch_state::on
+                                         : como::input::switch_state::off,
+                        .base = {&switch_device, time},
+                    });
+                }
+            },
+            event.data);
+    }
+
+    void inject_touch(recorded_touch const& data, uint32_t time)
+    {
+        switch (data.type) {
+        case recorded_touch_type::down:
+            redirect.touch->process_down({.id = data.id, .pos = data.pos, .base = {&touch, time}});
+            break;
+        case recorded_touch_type::motion:
+            redirect.touch->process_motion(
+                {.id = data.id, .pos = data.pos, .base = {&touch, time}});
+            break;
+        case recorded_touch_type::up:
+            redirect.touch->process_up({.id = data.id, .base = {&touch, time}});
+            break;
+        case recorded_touch_type::cancel:
+            redirect.touch->cancel();
+            break;
+        case recorded_touch_type::frame:
+            redirect.touch->frame();
+            break;
+        }
+    }
+
+    void inject_gesture(recorded_gesture const& data, uint32_t time)
+    {
+        auto& target = *redirect.pointer;
+
+        switch (data.type) {
+        case recorded_gesture_type::swipe_begin:
+            target.process_swipe_begin({.fingers = data.fingers, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::swipe_update:
+            target.process_swipe_update({.delta = data.delta, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::swipe_end:
+            target.process_swipe_end({.cancelled = data.cancelled, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::pinch_begin:
+            target.process_pinch_begin({.fingers = data.fingers, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::pinch_update:
+            target.process_pinch_update({
+                .scale = data.scale,
+                .rotation = data.rotation,
+                .delta = data.delta,
+                .base = {&pointer, time},
+            });
+            break;
+        case recorded_gesture_type::pinch_end:
+            target.process_pinch_end({.cancelled = data.cancelled, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::hold_begin:
+            target.process_hold_begin({.fingers = data.fingers, .base = {&pointer, time}});
+            break;
+        case recorded_gesture_type::hold_end:
+            target.process_hold_end({.cancelled = data.cancelled, .base = {&pointer, time}});
+            break;
+        }
+    }
+
+    Redirect& redirect;
+    std::unique_ptr<record_reader> reader;
+    std::optional<recorded_event> pending;
+
+    como::input::pointer pointer;
+    como::input::keyboard keyboard;
+    como::input::touch touch;
+    como::input::switch_device switch_device;
+
+    int timer_fd;
+    std::unique_ptr<QSocketNotifier> notifier;
+    timespec start_time{};
+};
+
+}
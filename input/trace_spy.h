@@ -0,0 +1,52 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "debug/trace.h"
+
+#include <como/input/event.h>
+#include <como/input/event_spy.h>
+
+namespace theseus_ship::input
+{
+
+/// Records input events received by the input redirect in the input trace category.
+template<typename Redirect>
+class trace_spy : public como::input::event_spy<Redirect>
+{
+public:
+    explicit trace_spy(Redirect& redirect)
+        : como::input::event_spy<Redirect>(redirect)
+    {
+    }
+
+    void motion(como::input::motion_event const& /*event*/) override
+    {
+        debug::trace::instant(debug::trace_category::input, "motion", "pointer");
+    }
+
+    void button(como::input::button_event const& event) override
+    {
+        debug::trace::instant(debug::trace_category::input,
+                              event.state == como::input::button_state::pressed ? "press"
+                                                                                : "release",
+                              "button");
+    }
+
+    void axis(como::input::axis_event const& /*event*/) override
+    {
+        debug::trace::instant(debug::trace_category::input, "axis", "pointer");
+    }
+
+    void key(como::input::key_event const& event) override
+    {
+        debug::trace::instant(debug::trace_category::input,
+                              event.state == como::input::key_state::pressed ? "press" : "release",
+                              "key");
+    }
+};
+
+}
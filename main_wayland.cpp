@@ -6,6 +6,30 @@ SPDX-License-Identifier: GPL-2.0-or-later
 */
 #include "main.h"
 
+#include "base/deferred_init.h"
+#include "base/launcher.h"
+#include "base/scheduling.h"
+#include "base/virtual_outputs.h"
+#include "base/wayland/client_traffic.h"
+#include "base/wayland/fd_accounting.h"
+#include "base/wayland/frame_throttling.h"
+#include "base/wayland/protocol_observer.h"
+#include "base/wayland/session_snapshot.h"
+#include "base/wayland/socket_activation.h"
+#include "debug/frame_stats.h"
+#include "debug/input_to_photon.h"
+#include "debug/startup_profiler.h"
+#include "debug/trace.h"
+#include "debug/wayland_frame_tracker.h"
+#include "input/device_snapshot.h"
+#include "input/motion_coalescer.h"
+#include "input/record_replay.h"
+#include "input/trace_spy.h"
+#include "render/lazy_effects.h"
+#include "xwl/lazy_xwayland.h"
+
+#include <config-theseus-ship.h>
+
 #include <como/base/wayland/app_singleton.h>
 #include <como/base/wayland/xwl_platform.h>
 #include <como/desktop/kde/platform.h>
@@ -14,14 +38,17 @@ SPDX-License-Identifier: GPL-2.0-or-later
 #include <como/script/platform.h>
 #include <como/win/shortcuts_init.h>
 
+#include <KSharedConfig>
 #include <KShell>
 #include <KSignalHandler>
 #include <KUpdateLaunchEnvironmentJob>
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QDebug>
-#include <QProcess>
+#include <QTimer>
 #include <sys/resource.h>
+#include <utility>
+#include <vector>
 
 namespace theseus_ship
 {
@@ -30,6 +57,7 @@ template<typename Base>
 struct input_mod {
     using platform_t = como::input::wayland::platform<Base, input_mod>;
     std::unique_ptr<como::input::dbus::device_manager<platform_t>> dbus;
+    std::unique_ptr<input::device_snapshot> device_snapshot;
 };
 
 struct space_mod {
@@ -42,11 +70,22 @@ struct base_mod {
     using input_t = como::input::wayland::platform<platform_t, input_mod<platform_t>>;
     using space_t = como::win::wayland::xwl_space<platform_t, space_mod>;
 
+    std::unique_ptr<base::wayland::protocol_observer> protocol_observer;
+    std::unique_ptr<base::wayland::fd_accounting> fd_accounting;
+    std::unique_ptr<base::wayland::frame_throttling> frame_throttling;
+    std::unique_ptr<base::wayland::client_traffic> client_traffic;
+    std::unique_ptr<debug::frame_stats> frame_stats;
+    std::unique_ptr<debug::wayland_frame_tracker> frame_tracker;
+    std::unique_ptr<debug::input_to_photon> input_to_photon;
+    std::unique_ptr<input::motion_coalescing> motion_coalescing;
+    std::unique_ptr<render::lazy_effects> lazy_effects;
     std::unique_ptr<render_t> render;
     std::unique_ptr<input_t> input;
     std::unique_ptr<space_t> space;
     std::unique_ptr<como::xwl::xwayland<space_t>> xwayland;
+    std::unique_ptr<xwl::lazy_xwayland> lazy_xwayland;
     std::unique_ptr<como::scripting::platform<space_t>> script;
+    std::unique_ptr<base::wayland::session_snapshot> session_snapshot;
 };
 
 }
@@ -91,30 +130,14 @@ static void bumpNofileLimit()
     pthread_atfork(nullptr, nullptr, restoreNofileLimit);
 }
 
-struct exit_process_t {
-    exit_process_t(QApplication& app)
-        : app{&app}
-    {
-    }
-    ~exit_process_t()
-    {
-        if (process && process->state() != QProcess::NotRunning) {
-            QObject::disconnect(process, nullptr, app, nullptr);
-            process->terminate();
-            process->waitForFinished(5000);
-        }
-    }
-
-    QApplication* app;
-    QProcess* process{nullptr};
-};
-
 }
 
 int main(int argc, char* argv[])
 {
     using namespace theseus_ship;
 
+    debug::startup_profiler profiler;
+
     // Redirect stderr output. This is useful as a workaround for missing logs in systemd journal
     // when launching a full Plasma session.
     if (auto log_path = getenv("KWIN_LOG_PATH")) {
@@ -129,6 +152,10 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // With socket activation clients connect to the socket systemd created. It is taken before
+    // anything else starts threads or processes that could see the LISTEN_* variables.
+    auto activated_socket = base::wayland::activated_socket::take();
+
     KLocalizedString::setApplicationDomain("kwin");
     bumpNofileLimit();
 
@@ -146,6 +173,10 @@ int main(int argc, char* argv[])
             QStringLiteral("xwayland"),
             i18n("Start a rootless Xwayland server."),
         };
+        QCommandLineOption xwl_on_demand = {
+            QStringLiteral("xwayland-on-demand"),
+            i18n("Start Xwayland only once the first X11 client connects. Implies --xwayland."),
+        };
         QCommandLineOption socket = {
             QStringList{QStringLiteral("s"), QStringLiteral("socket")},
             i18n("Name of the Wayland socket to listen on. If not set \"wayland-0\" is used."),
@@ -168,6 +199,60 @@ int main(int argc, char* argv[])
             i18n("Exit after the session application, which is started by KWin, closed."),
             QStringLiteral("/path/to/session"),
         };
+        QCommandLineOption scheduling_policy = {
+            QStringLiteral("scheduling-policy"),
+            i18n("Scheduling policy for compositing: normal, nice, rr or fifo."),
+            QStringLiteral("policy"),
+        };
+        QCommandLineOption scheduling_priority = {
+            QStringLiteral("scheduling-priority"),
+            i18n("Real-time priority or, with the nice policy, the nice value for compositing."),
+            QStringLiteral("priority"),
+        };
+        QCommandLineOption virtual_outputs = {
+            QStringLiteral("virtual"),
+            i18n("Render in software to virtual outputs, without any GPU or input devices."),
+        };
+        QCommandLineOption width = {
+            QStringLiteral("width"),
+            i18n("The width of virtual outputs. Default is 1280."),
+            QStringLiteral("width"),
+        };
+        QCommandLineOption height = {
+            QStringLiteral("height"),
+            i18n("The height of virtual outputs. Default is 720."),
+            QStringLiteral("height"),
+        };
+        QCommandLineOption output_count = {
+            QStringLiteral("output-count"),
+            i18n("The number of virtual outputs. Default is 1."),
+            QStringLiteral("count"),
+        };
+        QCommandLineOption scale = {
+            QStringLiteral("scale"),
+            i18n("The scale of virtual outputs. Default is 1."),
+            QStringLiteral("scale"),
+        };
+        QCommandLineOption record_input = {
+            QStringLiteral("record-input"),
+            i18n("Record received input events and surface commits of clients to a file."),
+            QStringLiteral("file"),
+        };
+        QCommandLineOption replay_input = {
+            QStringLiteral("replay-input"),
+            i18n("Replay input events from a recording. Best used together with --virtual."),
+            QStringLiteral("file"),
+        };
+        QCommandLineOption defer_scripting = {
+            QStringLiteral("defer-scripting"),
+            i18n("Load scripts only after the first frame was presented."),
+        };
+        QCommandLineOption restore = {
+            QStringLiteral("restore"),
+            i18n("Put reconnecting clients back where they were before the last restart. Also "
+                 "keeps the snapshot for the next restart, like the SessionSnapshot key in "
+                 "[Wayland]."),
+        };
     } options;
 
     QCommandLineParser parser;
@@ -175,21 +260,37 @@ int main(int argc, char* argv[])
     KAboutData::applicationData().setupCommandLine(&parser);
 
     parser.addOption(options.xwl);
+    parser.addOption(options.xwl_on_demand);
     parser.addOption(options.socket);
     parser.addOption(options.no_lockscreen);
     parser.addOption(options.no_global_shortcuts);
     parser.addOption(options.lockscreen);
     parser.addOption(options.exit_with_session);
+    parser.addOption(options.scheduling_policy);
+    parser.addOption(options.scheduling_priority);
+    parser.addOption(options.virtual_outputs);
+    parser.addOption(options.width);
+    parser.addOption(options.height);
+    parser.addOption(options.output_count);
+    parser.addOption(options.scale);
+    parser.addOption(options.record_input);
+    parser.addOption(options.replay_input);
+    parser.addOption(options.defer_scripting);
+    parser.addOption(options.restore);
     parser.addPositionalArgument(QStringLiteral("applications"),
                                  i18n("Applications to start once server is started"),
                                  QStringLiteral("[/path/to/application...]"));
 
+    profiler.start_phase(QStringLiteral("app"));
     como::base::wayland::app_singleton app(argc, argv);
 
     if (!como::Perf::Ftrace::setEnabled(qEnvironmentVariableIsSet("KWIN_PERF_FTRACE"))) {
         qWarning() << "Can't enable Ftrace via environment variable.";
     }
 
+    // Userspace alternative to ftrace, for systems without access to tracefs.
+    debug::tracer tracer;
+
     KSignalHandler::self()->watchSignal(SIGTERM);
     KSignalHandler::self()->watchSignal(SIGINT);
     KSignalHandler::self()->watchSignal(SIGHUP);
@@ -203,6 +304,58 @@ int main(int argc, char* argv[])
     parser.process(*app.qapp);
     KAboutData::applicationData().processCommandLine(&parser);
 
+    std::optional<base::virtual_outputs> virtual_outputs;
+    if (parser.isSet(options.virtual_outputs)) {
+        virtual_outputs = base::virtual_outputs();
+        auto valid = true;
+
+        auto read_int = [&](auto const& option, int& value) {
+            if (parser.isSet(option)) {
+                bool ok{false};
+                value = parser.value(option).toInt(&ok);
+                valid = valid && ok && value > 0;
+            }
+        };
+
+        int width{virtual_outputs->size.width()};
+        int height{virtual_outputs->size.height()};
+        read_int(options.width, width);
+        read_int(options.height, height);
+        read_int(options.output_count, virtual_outputs->count);
+        virtual_outputs->size = QSize(width, height);
+
+        if (parser.isSet(options.scale)) {
+            bool ok{false};
+            virtual_outputs->scale = parser.value(options.scale).toDouble(&ok);
+            valid = valid && ok && virtual_outputs->scale > 0;
+        }
+
+        if (!valid) {
+            std::cerr << "Invalid size, count or scale for virtual outputs." << std::endl;
+            return 1;
+        }
+
+        base::setup_virtual_backend(*virtual_outputs);
+    }
+
+    auto scheduling_config = base::load_scheduling_config(
+        KSharedConfig::openConfig(QStringLiteral("kwinrc"))->group(QStringLiteral("Compositing")));
+    if (parser.isSet(options.scheduling_policy)) {
+        auto const policy = parser.value(options.scheduling_policy);
+        if (auto parsed = base::scheduling_policy_from_string(policy)) {
+            scheduling_config.policy = *parsed;
+        } else {
+            std::cerr << "Unknown scheduling policy: " << qPrintable(policy) << std::endl;
+            return 1;
+        }
+    }
+    if (parser.isSet(options.scheduling_priority)) {
+        scheduling_config.priority = parser.value(options.scheduling_priority).toInt();
+    }
+
+    // Rendering and presenting happens on the main thread, which is the calling one.
+    base::scheduling scheduling(scheduling_config);
+
     auto flags = como::base::wayland::start_options::none;
     if (parser.isSet(options.lockscreen)) {
         flags = como::base::wayland::start_options::lock_screen;
@@ -215,47 +368,312 @@ int main(int argc, char* argv[])
 
     qDebug("Starting Theseus' Ship (Wayland) %s", "0.0.0");
 
-    exit_process_t exit_process(*app.qapp);
+    // Created once the environment is complete. Terminates the session process at the very end.
+    std::unique_ptr<base::launcher> launcher;
+
+    auto const xwayland_on_demand = parser.isSet(options.xwl_on_demand);
+
+    profiler.start_phase(QStringLiteral("base"));
+
+    // The compositor still binds its own socket, which must not clobber the activated one.
+    auto socket_name = parser.value(options.socket).toStdString();
+    if (activated_socket && socket_name.empty()) {
+        socket_name = activated_socket->name() + "-direct";
+    }
 
     using base_t = como::base::wayland::xwl_platform<base_mod>;
     base_t base({
         .config = como::base::config(KConfig::OpenFlag::FullConfig, "kwinrc"),
-        .socket_name = parser.value(options.socket).toStdString(),
+        .socket_name = socket_name,
         .flags = flags,
-        .mode = parser.isSet(options.xwl) ? como::base::operation_mode::xwayland
-                                          : como::base::operation_mode::wayland,
+        .mode = parser.isSet(options.xwl) || xwayland_on_demand
+            ? como::base::operation_mode::xwayland
+            : como::base::operation_mode::wayland,
     });
 
+    if (activated_socket) {
+        // Clients may connect from now on. They are served once the event loop runs, so the
+        // session can start in parallel with the remaining initialization.
+        if (activated_socket->add_to(base.server->display->native())) {
+            base::wayland::notify_service_manager("READY=1");
+        } else {
+            activated_socket.reset();
+        }
+    }
+
+    // Clients can connect from now on, either to the activated or to our own socket.
+    profiler.mark(QStringLiteral("socket-ready"));
+
+    profiler.start_phase(QStringLiteral("render"));
     base.mod.render = std::make_unique<base_t::render_t>(base);
 
+    profiler.start_phase(QStringLiteral("input"));
     base.mod.input
         = std::make_unique<base_t::input_t>(base, como::input::config(KConfig::NoGlobals));
     base.mod.input->mod.dbus
         = std::make_unique<como::input::dbus::device_manager<base_t::input_t>>(*base.mod.input);
+    base.mod.input->mod.device_snapshot = std::make_unique<input::device_snapshot>();
 
+    profiler.start_phase(QStringLiteral("space"));
     base.mod.space = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
+
+    profiler.start_phase(QStringLiteral("desktop"));
     base.mod.space->mod.desktop
         = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
+
+    profiler.start_phase(QStringLiteral("shortcuts"));
     como::win::init_shortcuts(*base.mod.space);
     como::render::init_shortcuts(*base.mod.render);
-    base.mod.script = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
 
+    auto create_scripting = [&base] {
+        debug::trace::scope trace(debug::trace_category::scripting, "create-scripting");
+        base.mod.script
+            = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+    };
+
+    // Scripts are not needed to show the first frame. Load them right after it.
+    std::unique_ptr<base::deferred_init> deferred_scripting;
+    if (parser.isSet(options.defer_scripting)) {
+        deferred_scripting = std::make_unique<base::deferred_init>(std::chrono::seconds(3));
+        deferred_scripting->add_step(QStringLiteral("scripting"), create_scripting);
+    } else {
+        profiler.start_phase(QStringLiteral("scripting"));
+        create_scripting();
+    }
+
+    // Effects idle until activated are not needed to show the first frame.
+    base.mod.lazy_effects = std::make_unique<render::lazy_effects>(
+        base.config.main,
+        render::load_lazy_effects_config(KConfigGroup(base.config.main, QStringLiteral("Effects"))),
+        render::create_effects_loader(base));
+
+    profiler.start_phase(QStringLiteral("platform-start"));
     como::base::wayland::platform_start(base);
 
+    if (virtual_outputs) {
+        base::apply_virtual_outputs(base, *virtual_outputs);
+        base::restore_environment(*virtual_outputs);
+    }
+
+    base.mod.protocol_observer
+        = std::make_unique<base::wayland::protocol_observer>(base.server->display->native());
+
+    // The raised fd limit is shared by all clients. Keep track of who consumes it.
+    auto const fd_config = base::wayland::load_fd_accounting_config(
+        KConfigGroup(base.config.main, QStringLiteral("Wayland")));
+    base.mod.fd_accounting = std::make_unique<base::wayland::fd_accounting>(
+        *base.mod.protocol_observer, fd_config);
+
+    // Abusive clients can be throttled through their frame callbacks.
+    auto const traffic_config = base::wayland::load_client_traffic_config(
+        KConfigGroup(base.config.main, QStringLiteral("Wayland")));
+    auto const throttle_traffic = traffic_config.enabled
+        && traffic_config.action == base::wayland::client_traffic_action::throttle;
+
+    auto throttling_config = base::wayland::load_frame_throttling_config(
+        KConfigGroup(base.config.main, QStringLiteral("FrameThrottling")));
+    if (throttle_traffic || throttling_config.hidden_rate >= 0
+        || !throttling_config.rules.empty()) {
+#if KWIN_BUILD_FRAME_THROTTLING
+        base.mod.frame_throttling = std::make_unique<base::wayland::frame_throttling>(
+            *base.mod.protocol_observer,
+            base.server->display->native(),
+            std::move(throttling_config));
+#else
+        qWarning() << "Frame throttling is configured, but was not enabled at build time.";
+#endif
+    }
+
+    if (traffic_config.enabled) {
+        base.mod.client_traffic
+            = std::make_unique<base::wayland::client_traffic>(*base.mod.protocol_observer,
+                                                              base.server->display->native(),
+                                                              traffic_config,
+                                                              base.mod.frame_throttling.get());
+    }
+
+    base.mod.frame_stats = std::make_unique<debug::frame_stats>();
+    base.mod.frame_tracker = std::make_unique<debug::wayland_frame_tracker>(*base.mod.frame_stats);
+
+    // Frames are timed by the present events of the backend outputs, including hotplugged ones.
+    auto track_output = [&base](auto output) {
+        base.mod.frame_tracker->add_output(
+            static_cast<base_t::backend_t::output_t*>(output)->native);
+    };
+    for (auto output : base.outputs) {
+        track_output(output);
+    }
+    QObject::connect(base.qobject.get(),
+                     &como::base::platform_qobject::output_added,
+                     base.mod.frame_stats.get(),
+                     track_output);
+    base.mod.input_to_photon
+        = std::make_unique<debug::input_to_photon>(*base.mod.protocol_observer);
+    if (KConfigGroup(base.config.main, QStringLiteral("Wayland"))
+            .readEntry("InputToPhoton", false)) {
+        base.mod.input_to_photon->start();
+    }
+    QObject::connect(base.mod.frame_stats.get(),
+                     &debug::frame_stats::first_frame_presented,
+                     &profiler,
+                     [&profiler] { profiler.mark(QStringLiteral("first-frame")); });
+    QObject::connect(base.mod.frame_stats.get(),
+                     &debug::frame_stats::first_frame_presented,
+                     base.mod.frame_stats.get(),
+                     [&base] { base.mod.lazy_effects->trigger(); });
+    if (deferred_scripting) {
+        QObject::connect(base.mod.frame_stats.get(),
+                         &debug::frame_stats::first_frame_presented,
+                         base.mod.frame_stats.get(),
+                         [&deferred_scripting] { deferred_scripting->trigger(); });
+    }
+
+    // Looking at every message costs, so the sink only exists while the category is enabled.
+    std::optional<int> wayland_trace_sink;
+    auto update_wayland_trace = [&base, &wayland_trace_sink] {
+        auto const enabled = debug::trace::is_enabled(debug::trace_category::wayland);
+        if (enabled && !wayland_trace_sink) {
+            wayland_trace_sink
+                = base.mod.protocol_observer->add_sink([](auto, auto const& message) {
+                      // Both names are static strings of the protocol definitions.
+                      debug::trace::instant(debug::trace_category::wayland,
+                                            message.message->name,
+                                            wl_resource_get_class(message.resource));
+                  });
+        } else if (!enabled && wayland_trace_sink) {
+            base.mod.protocol_observer->remove_sink(*wayland_trace_sink);
+            wayland_trace_sink.reset();
+        }
+    };
+    update_wayland_trace();
+    QObject::connect(
+        &tracer, &debug::tracer::categories_changed, base.qobject.get(), update_wayland_trace);
+
+    // Surfaces enter an output once they are mapped.
+    base.mod.protocol_observer->add_sink(
+        "wl_surface", "enter", [&profiler, mapped = false](auto, auto const&) mutable {
+            if (!mapped) {
+                mapped = true;
+                profiler.mark(QStringLiteral("first-client-mapped"));
+            }
+        });
+
+    using redirect_t = base_t::space_t::input_t;
+    auto trace_spy = std::make_unique<input::trace_spy<redirect_t>>(*base.mod.space->input);
+    base.mod.space->input->installInputEventSpy(trace_spy.get());
+
+    std::unique_ptr<input::input_recorder<redirect_t>> input_recorder;
+    std::unique_ptr<input::input_replay<redirect_t>> input_replay;
+
+    if (parser.isSet(options.record_input)) {
+        auto writer = std::make_unique<input::record_writer>(parser.value(options.record_input));
+        if (writer->is_open()) {
+            input_recorder = std::make_unique<input::input_recorder<redirect_t>>(
+                *base.mod.space->input, *base.mod.protocol_observer, std::move(writer));
+            base.mod.space->input->installInputEventSpy(input_recorder.get());
+        } else {
+            qWarning() << "Failed to open" << parser.value(options.record_input)
+                       << "for recording input.";
+        }
+    }
+
+    // Recordings hold received and merged motion alike. Replaying them would move twice as far.
+    std::unique_ptr<input::motion_coalescer<redirect_t>> motion_coalescer;
+    auto const coalescing_config = input::load_motion_coalescing_config(
+        KConfigGroup(base.config.main, QStringLiteral("Input")));
+    if (coalescing_config.enabled && !input_recorder) {
+        base.mod.motion_coalescing
+            = std::make_unique<input::motion_coalescing>(*base.mod.protocol_observer);
+        motion_coalescer = std::make_unique<input::motion_coalescer<redirect_t>>(
+            *base.mod.space->input, *base.mod.motion_coalescing);
+        base.mod.space->input->prependInputEventFilter(motion_coalescer.get());
+
+        // Held motion is sent on when an output starts its next frame.
+        auto add_output = [&base](auto output) {
+            base.mod.motion_coalescing->add_output(
+                static_cast<base_t::backend_t::output_t*>(output)->native);
+        };
+        for (auto output : base.outputs) {
+            add_output(output);
+        }
+        QObject::connect(base.qobject.get(),
+                         &como::base::platform_qobject::output_added,
+                         base.mod.motion_coalescing.get(),
+                         add_output);
+    }
+
+    if (parser.isSet(options.replay_input)) {
+        auto reader = std::make_unique<input::record_reader>(parser.value(options.replay_input));
+        if (reader->is_valid()) {
+            input_replay = std::make_unique<input::input_replay<redirect_t>>(
+                *base.mod.space->input, std::move(reader));
+            input_replay->start();
+        } else {
+            qWarning() << parser.value(options.replay_input) << "is not a valid input recording.";
+        }
+    }
+
     base.process_environment = QProcessEnvironment::systemEnvironment();
 
-    if (auto const& name = base.server->display->socket_name(); !name.empty()) {
+    if (activated_socket) {
+        base.process_environment.insert(QStringLiteral("WAYLAND_DISPLAY"),
+                                        QString::fromStdString(activated_socket->name()));
+    } else if (auto const& name = base.server->display->socket_name(); !name.empty()) {
         base.process_environment.insert(QStringLiteral("WAYLAND_DISPLAY"), name.c_str());
     }
 
+    // Only the compositor itself reports to the service manager.
+    base.process_environment.remove(QStringLiteral("NOTIFY_SOCKET"));
+
+    // Qt clients survive a compositor restart by reconnecting. The snapshot puts them back. Both
+    // are opt-in, since reconnecting changes how clients behave when the compositor goes away.
+    auto const session_snapshot_enabled = parser.isSet(options.restore)
+        || KConfigGroup(base.config.main, QStringLiteral("Wayland"))
+               .readEntry("SessionSnapshot", false);
+    if (session_snapshot_enabled) {
+        base.process_environment.insert(QStringLiteral("QT_WAYLAND_RECONNECT"),
+                                        QStringLiteral("1"));
+        base.mod.session_snapshot = std::make_unique<base::wayland::session_snapshot>(
+            QString::fromStdString(base.server->display->socket_name()));
+        if (parser.isSet(options.restore)) {
+            base.mod.session_snapshot->restore();
+        }
+    }
+
+    std::vector<std::pair<QString, QString>> bundled_scripts;
+    if (base.mod.session_snapshot) {
+        bundled_scripts.emplace_back(base::wayland::session_snapshot::script_path(),
+                                     QStringLiteral("theseus-ship-session-snapshot"));
+    }
+    if (base.mod.frame_throttling) {
+        bundled_scripts.emplace_back(base::wayland::frame_throttling::script_path(),
+                                     QStringLiteral("theseus-ship-frame-throttling"));
+    }
+
+    // Loading only registers a script with como. Starting runs the registered scripts that are
+    // not running yet, so without bundled scripts it is left to como as before.
+    for (auto const& script : bundled_scripts) {
+        auto load_script = [&base, script] {
+            debug::trace::scope trace(debug::trace_category::scripting, "load-script");
+            base.mod.script->loadScript(script.first, script.second);
+            base.mod.script->start();
+        };
+        if (deferred_scripting) {
+            deferred_scripting->add_step(script.second, load_script);
+        } else {
+            load_script();
+        }
+    }
+
+    profiler.start_phase(QStringLiteral("screen-locker"));
     base.mod.space->mod.desktop->screen_locker
         = std::make_unique<como::desktop::kde::screen_locker>(
             *base.server, base.process_environment, parser.isSet(options.lockscreen));
 
-    if (base.operation_mode == como::base::operation_mode::xwayland) {
+    auto start_xwayland = [&base](auto&&... socket) {
         try {
-            base.mod.xwayland
-                = std::make_unique<como::xwl::xwayland<base_t::space_t>>(*base.mod.space);
+            base.mod.xwayland = std::make_unique<como::xwl::xwayland<base_t::space_t>>(
+                *base.mod.space, std::forward<decltype(socket)>(socket)...);
         } catch (std::system_error const& exc) {
             std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
             exit(exc.code().value());
@@ -263,28 +681,49 @@ int main(int argc, char* argv[])
             std::cerr << "FATAL ERROR creating Xwayland: " << exc.what() << std::endl;
             exit(1);
         }
+    };
+
+    if (base.operation_mode == como::base::operation_mode::xwayland) {
+        profiler.start_phase(QStringLiteral("xwayland"));
+
+        if (xwayland_on_demand) {
+            // Xwayland takes over the reserved display with its bound listening sockets.
+            base.mod.lazy_xwayland = std::make_unique<xwl::lazy_xwayland>(
+                [start_xwayland](auto display, auto listen_fds) {
+                    start_xwayland(como::xwl::socket(display, std::move(listen_fds)));
+                });
+        }
+
+        if (base.mod.lazy_xwayland && base.mod.lazy_xwayland->is_valid()) {
+            base.process_environment.insert(QStringLiteral("DISPLAY"),
+                                            base.mod.lazy_xwayland->display_name());
+        } else {
+            base.mod.lazy_xwayland.reset();
+            start_xwayland();
+        }
     }
 
+    profiler.start_phase(QStringLiteral("session"));
     auto process_environment = base.process_environment;
 
     // Enforce Wayland platform for started Qt apps. They otherwise for some reason prefer X11.
     process_environment.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("wayland"));
 
+    std::optional<rlimit> child_nofile_limit;
+    if (originalNofileLimit.rlim_cur) {
+        child_nofile_limit = originalNofileLimit;
+    }
+    launcher = std::make_unique<base::launcher>(process_environment, child_nofile_limit);
+
     // start session
     if (parser.isSet(options.exit_with_session) /*&& !m_sessionArgument.isEmpty()*/) {
         auto arguments = KShell::splitArgs(parser.value(options.exit_with_session));
         if (!arguments.isEmpty()) {
-            QString program = arguments.takeFirst();
-            auto p = new QProcess(app.qapp.get());
-            p->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-            p->setProcessEnvironment(process_environment);
-            QObject::connect(p,
-                             qOverload<int, QProcess::ExitStatus>(&QProcess::finished),
+            QObject::connect(launcher.get(),
+                             &base::launcher::session_finished,
                              app.qapp.get(),
-                             [&exit_process, p](auto code, auto status) {
-                                 exit_process.process = {};
-                                 p->deleteLater();
-                                 if (status == QProcess::CrashExit) {
+                             [](auto code, auto crashed) {
+                                 if (crashed) {
                                      qWarning() << "Session process has crashed";
                                      QCoreApplication::exit(-1);
                                      return;
@@ -296,10 +735,7 @@ int main(int argc, char* argv[])
 
                                  QCoreApplication::exit(code);
                              });
-            p->setProgram(program);
-            p->setArguments(arguments);
-            p->start();
-            exit_process.process = p;
+            launcher->launch_session(arguments);
         } else {
             qWarning("Failed to launch the session process: %s is an invalid command",
                      qPrintable(parser.value(options.exit_with_session)));
@@ -315,16 +751,9 @@ int main(int argc, char* argv[])
                          qPrintable(app_name));
                 continue;
             }
-            QString program = arguments.takeFirst();
             // note: this will kill the started process when we exit
             // this is going to happen anyway as we are the wayland and X server the app connects to
-            auto p = new QProcess(app.qapp.get());
-            p->setProcessChannelMode(QProcess::ForwardedErrorChannel);
-            p->setProcessEnvironment(process_environment);
-            p->setProgram(program);
-            p->setArguments(arguments);
-            p->startDetached();
-            p->deleteLater();
+            launcher->launch(arguments);
         }
     }
 
@@ -337,5 +766,7 @@ int main(int argc, char* argv[])
         QDBusConnection::sessionBus().registerService(QStringLiteral("org.kde.KWinWrapper"));
     });
 
+    QTimer::singleShot(0, &profiler, [&profiler] { profiler.finish(); });
+
     return app.qapp->exec();
 }
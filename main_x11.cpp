@@ -8,6 +8,15 @@
 */
 #include "main.h"
 
+#include "base/deferred_init.h"
+#include "base/x11/restart_snapshot.h"
+#include "debug/frame_stats.h"
+#include "debug/startup_profiler.h"
+#include "debug/trace.h"
+#include "debug/x11_frame_tracker.h"
+#include "debug/x11_round_trips.h"
+#include "render/lazy_effects.h"
+
 #include <como/base/seat/backend/logind/session.h>
 #include <como/base/x11/app_singleton.h>
 #include <como/base/x11/platform.h>
@@ -25,13 +34,21 @@
 #include <QDBusMessage>
 #include <QDBusPendingCall>
 #include <QFile>
+#include <ctime>
+#include <fcntl.h>
 #include <iostream>
+#include <string>
+#include <unistd.h>
 
 namespace
 {
 
 int crash_count = 0;
 
+// Prepared before crashing, as the handler must not allocate or call into Qt.
+std::string restart_program;
+int restart_snapshot_fd{-1};
+
 void notify_ksplash()
 {
     // Tell KSplash that KWin has started
@@ -50,14 +67,34 @@ void crash_handler(int signal)
 
     fprintf(
         stderr, "crash_handler() called with signal %d; recent crashes: %d\n", signal, crash_count);
-    char cmd[1024];
-    sprintf(cmd,
-            "%s --crashes %d &",
-            QFile::encodeName(QCoreApplication::applicationFilePath()).constData(),
-            crash_count);
-
-    sleep(1);
-    system(cmd);
+
+    char count_arg[16];
+    char fd_arg[16];
+    snprintf(count_arg, sizeof(count_arg), "%d", crash_count);
+    snprintf(fd_arg, sizeof(fd_arg), "%d", restart_snapshot_fd);
+
+    auto const crashed = getpid();
+    if (fork() != 0) {
+        return;
+    }
+
+    // Only async-signal-safe calls from here on. Wait for the crashed instance to be gone, but
+    // not longer than a second, since it might be kept alive for a crash report.
+    timespec const step{.tv_sec = 0, .tv_nsec = 10 * 1000 * 1000};
+    for (int i = 0; i < 100 && getppid() == crashed; ++i) {
+        nanosleep(&step, nullptr);
+    }
+
+    char const* argv[]
+        = {restart_program.c_str(), "--crashes", count_arg, "--restore-fd", fd_arg, nullptr};
+    if (restart_snapshot_fd < 0) {
+        argv[3] = nullptr;
+    } else {
+        fcntl(restart_snapshot_fd, F_SETFD, 0);
+    }
+
+    execv(restart_program.c_str(), const_cast<char* const*>(argv));
+    _exit(1);
 }
 
 }
@@ -79,6 +116,10 @@ struct base_mod {
     std::unique_ptr<input_t> input;
     std::unique_ptr<space_t> space;
     std::unique_ptr<como::scripting::platform<space_t>> script;
+    std::unique_ptr<base::x11::restart_snapshot> restart_snapshot;
+    std::unique_ptr<debug::frame_stats> frame_stats;
+    std::unique_ptr<debug::x11_frame_tracker> frame_tracker;
+    std::unique_ptr<render::lazy_effects> lazy_effects;
 };
 
 }
@@ -87,16 +128,26 @@ int main(int argc, char* argv[])
 {
     using namespace theseus_ship;
 
+    debug::startup_profiler profiler;
+    std::unique_ptr<debug::x11_round_trips> round_trips;
+    if (debug::x11_round_trips::is_enabled()) {
+        round_trips = std::make_unique<debug::x11_round_trips>(profiler);
+    }
+
     KLocalizedString::setApplicationDomain("kwin");
 
     signal(SIGPIPE, SIG_IGN);
 
+    profiler.start_phase(QStringLiteral("app"));
     como::base::x11::app_singleton app(argc, argv);
 
     if (!como::Perf::Ftrace::setEnabled(qEnvironmentVariableIsSet("KWIN_PERF_FTRACE"))) {
         qWarning() << "Can't enable Ftrace via environment variable.";
     }
 
+    // Userspace alternative to ftrace, for systems without access to tracefs.
+    debug::tracer tracer;
+
     KSignalHandler::self()->watchSignal(SIGTERM);
     KSignalHandler::self()->watchSignal(SIGINT);
     KSignalHandler::self()->watchSignal(SIGHUP);
@@ -112,6 +163,14 @@ int main(int argc, char* argv[])
     QCommandLineOption replaceOption(
         QStringLiteral("replace"),
         i18n("Replace already-running ICCCM2.0-compliant window manager"));
+    QCommandLineOption restoreFdOption(
+        QStringLiteral("restore-fd"),
+        i18n("Restore the window state from a snapshot left by a crashed instance"),
+        QStringLiteral("fd"));
+    restoreFdOption.setFlags(QCommandLineOption::HiddenFromHelp);
+    QCommandLineOption deferScriptingOption(
+        QStringLiteral("defer-scripting"),
+        i18n("Load scripts only after the first frame was presented"));
 
     QCommandLineParser parser;
     parser.setApplicationDescription(i18n("Theseus' Ship X11 Window Manager"));
@@ -119,6 +178,8 @@ int main(int argc, char* argv[])
 
     parser.addOption(crashesOption);
     parser.addOption(replaceOption);
+    parser.addOption(restoreFdOption);
+    parser.addOption(deferScriptingOption);
 
     parser.process(*app.qapp);
 
@@ -126,14 +187,28 @@ int main(int argc, char* argv[])
 
     KAboutData::applicationData().processCommandLine(&parser);
     crash_count = parser.value("crashes").toInt();
+    restart_program = QFile::encodeName(QCoreApplication::applicationFilePath()).toStdString();
+
+    std::optional<base::x11::restart_state> restart_state;
+    if (parser.isSet(restoreFdOption)) {
+        restart_state = base::x11::read_restart_state(parser.value(restoreFdOption).toInt());
+    }
 
+    profiler.start_phase(QStringLiteral("base"));
     using base_t = como::base::x11::platform<base_mod>;
     base_t base(como::base::config(KConfig::OpenFlag::FullConfig, "kwinrc"));
 
     KCrash::setEmergencySaveFunction(crash_handler);
     como::base::x11::platform_init_crash_count(base, crash_count);
 
-    auto handle_ownership_claimed = [&base] {
+    // Scripts are not needed to show the first frame. Load them right after it.
+    std::unique_ptr<base::deferred_init> deferred_scripting;
+    if (parser.isSet(deferScriptingOption)) {
+        deferred_scripting = std::make_unique<base::deferred_init>(std::chrono::seconds(3));
+    }
+
+    auto handle_ownership_claimed = [&base, &profiler, &restart_state, &deferred_scripting] {
+        profiler.start_phase(QStringLiteral("options"));
         base.options
             = como::base::create_options(como::base::operation_mode::x11, base.config.main);
 
@@ -158,12 +233,18 @@ int main(int argc, char* argv[])
         }
 
         base.session = std::make_unique<como::base::seat::backend::logind::session>();
+
+        profiler.start_phase(QStringLiteral("render"));
         base.mod.render = std::make_unique<como::render::backend::x11::platform<base_t>>(base);
+
+        profiler.start_phase(QStringLiteral("input"));
         base.mod.input = std::make_unique<como::input::x11::platform<base_t>>(base);
 
+        profiler.start_phase(QStringLiteral("outputs"));
         base.update_outputs();
         auto render
             = static_cast<como::render::backend::x11::platform<base_t>*>(base.mod.render.get());
+        profiler.start_phase(QStringLiteral("render-init"));
         try {
             render->init();
         } catch (std::exception const&) {
@@ -171,6 +252,7 @@ int main(int argc, char* argv[])
             ::exit(1);
         }
 
+        profiler.start_phase(QStringLiteral("space"));
         try {
             base.mod.space = std::make_unique<base_t::space_t>(*base.mod.render, *base.mod.input);
         } catch (std::exception& ex) {
@@ -178,20 +260,90 @@ int main(int argc, char* argv[])
             exit(1);
         }
 
+        profiler.start_phase(QStringLiteral("desktop"));
         base.mod.space->mod.desktop
             = std::make_unique<como::desktop::kde::platform<base_t::space_t>>(*base.mod.space);
+
+        profiler.start_phase(QStringLiteral("shortcuts"));
         como::win::init_shortcuts(*base.mod.space);
         como::render::init_shortcuts(*base.mod.render);
 
-        base.mod.script
-            = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+        auto create_scripting = [&base] {
+            debug::trace::scope trace(debug::trace_category::scripting, "create-scripting");
+            base.mod.script
+                = std::make_unique<como::scripting::platform<base_t::space_t>>(*base.mod.space);
+        };
+
+        if (deferred_scripting) {
+            deferred_scripting->add_step(QStringLiteral("scripting"), create_scripting);
+        } else {
+            profiler.start_phase(QStringLiteral("scripting"));
+            create_scripting();
+        }
+
+        // Effects idle until activated are not needed to show the first frame.
+        base.mod.lazy_effects = std::make_unique<render::lazy_effects>(
+            base.config.main,
+            render::load_lazy_effects_config(
+                KConfigGroup(base.config.main, QStringLiteral("Effects"))),
+            render::create_effects_loader(base));
+
+        profiler.start_phase(QStringLiteral("render-start"));
         render->start(*base.mod.space);
 
+        base.mod.frame_stats = std::make_unique<debug::frame_stats>();
+        QObject::connect(base.mod.frame_stats.get(),
+                         &debug::frame_stats::first_frame_presented,
+                         &profiler,
+                         [&profiler] { profiler.mark(QStringLiteral("first-frame")); });
+        if (deferred_scripting) {
+            QObject::connect(base.mod.frame_stats.get(),
+                             &debug::frame_stats::first_frame_presented,
+                             base.mod.frame_stats.get(),
+                             [&deferred_scripting] { deferred_scripting->trigger(); });
+        }
+        QObject::connect(base.mod.frame_stats.get(),
+                         &debug::frame_stats::first_frame_presented,
+                         base.mod.frame_stats.get(),
+                         [&base] { base.mod.lazy_effects->trigger(); });
+        base.mod.frame_tracker = std::make_unique<debug::x11_frame_tracker>(*base.mod.frame_stats);
+        if (base.mod.frame_tracker->is_valid()) {
+            // Frames are presented to the compositor's overlay window, which only exists while
+            // compositing.
+            auto update_overlay = [&base] {
+                auto const& overlay = base.mod.render->overlay_window;
+                base.mod.frame_tracker->set_overlay(overlay ? overlay->window() : XCB_WINDOW_NONE);
+            };
+            update_overlay();
+            QObject::connect(base.mod.render->qobject.get(),
+                             &como::render::compositor_qobject::compositingToggled,
+                             base.mod.frame_stats.get(),
+                             update_overlay);
+        } else {
+            base.mod.frame_tracker.reset();
+        }
+
         // Trigger possible errors, there's still a chance to abort.
         como::base::x11::xcb::sync(base.x11_data.connection);
+
+        if (restart_state) {
+            base::x11::apply_restart_state(
+                base.x11_data.connection, base.x11_data.root_window, *restart_state);
+            restart_state.reset();
+        }
+
+        base.mod.restart_snapshot = std::make_unique<base::x11::restart_snapshot>();
+        if (base.mod.restart_snapshot->is_valid()) {
+            restart_snapshot_fd = base.mod.restart_snapshot->fd();
+        } else {
+            base.mod.restart_snapshot.reset();
+        }
+
         notify_ksplash();
+        profiler.finish();
     };
 
+    profiler.start_phase(QStringLiteral("ownership"));
     como::base::x11::platform_start(base, parser.isSet(replaceOption), handle_ownership_claimed);
 
     return app.qapp->exec();
@@ -0,0 +1,112 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "lazy_effects.h"
+
+#include <KConfigGroup>
+#include <KPluginMetaData>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <utility>
+
+namespace theseus_ship::render
+{
+
+namespace
+{
+
+// Deferred effects are loaded at the latest after this time, when no frame was presented.
+constexpr std::chrono::seconds load_timeout{3};
+
+KConfigGroup plugins_group(KSharedConfigPtr const& config)
+{
+    return config->group(QStringLiteral("Plugins"));
+}
+
+QString enabled_key(QString const& name)
+{
+    return name + QStringLiteral("Enabled");
+}
+
+}
+
+QStringList load_lazy_effects_config(KConfigGroup const& group)
+{
+    return group.readEntry("LazyEffects", QStringList());
+}
+
+lazy_effects::lazy_effects(KSharedConfigPtr config,
+                           QStringList const& candidates,
+                           effects_loader loader)
+    : config{std::move(config)}
+    , loader{std::move(loader)}
+    , deferred{load_timeout}
+{
+    // Looking up the plugins takes time on the startup path.
+    if (candidates.isEmpty()) {
+        return;
+    }
+
+    auto group = plugins_group(this->config);
+    auto const plugins = KPluginMetaData::findPlugins(QStringLiteral("kwin/effects/plugins"));
+
+    for (auto const& plugin : plugins) {
+        if (!candidates.contains(plugin.pluginId()) || !plugin.isEnabled(group)) {
+            continue;
+        }
+
+        // Without the persistent flag the entry is never written back to disk.
+        group.writeEntry(enabled_key(plugin.pluginId()), false, KConfigBase::WriteConfigFlags());
+        hidden.push_back(plugin.pluginId());
+    }
+
+    for (auto const& name : std::as_const(hidden)) {
+        deferred.add_step(QStringLiteral("effect ") + name, [this, name] { load(name); });
+    }
+    if (!hidden.isEmpty()) {
+        deferred.add_step(QStringLiteral("effects summary"), [this] { report(); });
+    }
+}
+
+QStringList const& lazy_effects::effects() const
+{
+    return hidden;
+}
+
+void lazy_effects::trigger()
+{
+    deferred.trigger();
+}
+
+void lazy_effects::load(QString const& name)
+{
+    // Undo the override first so a later reconfigure keeps the effect loaded.
+    plugins_group(config).writeEntry(enabled_key(name), true, KConfigBase::WriteConfigFlags());
+
+    // A reconfigure in the meantime may have loaded it already.
+    if (loader.is_loaded(name)) {
+        return;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    if (!loader.load(name)) {
+        qWarning() << "Failed to load deferred effect" << name;
+        return;
+    }
+
+    total_duration += std::chrono::milliseconds(clock.elapsed());
+    loaded++;
+}
+
+void lazy_effects::report() const
+{
+    qInfo("Deferred loading %d effects, moving %lld ms off the startup path.",
+          loaded,
+          static_cast<long long>(total_duration.count()));
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include "base/deferred_init.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+#include <QStringList>
+#include <chrono>
+#include <functional>
+
+namespace theseus_ship::render
+{
+
+/// Reads the LazyEffects entry of the Effects group. It is empty by default, so no effect is
+/// deferred. Good candidates are effects idle until activated by the user, like zoom or overview.
+QStringList load_lazy_effects_config(KConfigGroup const& group);
+
+/// Loads effects into the running compositor by name.
+struct effects_loader {
+    std::function<bool(QString const&)> is_loaded;
+    std::function<bool(QString const&)> load;
+};
+
+/// Calls the effects handler of @p base directly. It is looked up on each call, since it only
+/// exists while compositing.
+template<typename Base>
+effects_loader create_effects_loader(Base& base)
+{
+    return {
+        [&base](auto const& name) {
+            auto const& effects = base.mod.render->effects;
+            return effects && effects->isEffectLoaded(name);
+        },
+        [&base](auto const& name) {
+            auto const& effects = base.mod.render->effects;
+            return effects && effects->loadEffect(name);
+        },
+    };
+}
+
+/**
+ * Defers loading enabled effects until after compositor start. This only moves their load time
+ * off the startup path. Once loaded they are regular effects, so no memory is saved.
+ *
+ * The effects are hidden by disabling them in memory only, so kwinrc on disk is not changed.
+ * They are loaded again one at a time through the effects handler, once triggered or at the
+ * latest after a timeout. The load time moved off the startup path is logged.
+ */
+class lazy_effects
+{
+public:
+    /// Must be created before the compositor starts, so the effects are not loaded right away.
+    lazy_effects(KSharedConfigPtr config, QStringList const& candidates, effects_loader loader);
+
+    QStringList const& effects() const;
+
+    /// Starts loading the effects, for example once the first frame was presented.
+    void trigger();
+
+private:
+    void load(QString const& name);
+    void report() const;
+
+    KSharedConfigPtr config;
+    QStringList hidden;
+    effects_loader loader;
+    base::deferred_init deferred;
+    std::chrono::milliseconds total_duration{0};
+    int loaded{0};
+};
+
+}
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+
+# SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+"""Measures the startup of kwin_wayland on virtual outputs.
+
+Each run starts the compositor with a fresh runtime directory and a client to map. The startup
+trace written to KWIN_STARTUP_TRACE provides the time from process start to the socket being
+ready, the first client being mapped and the first frame being presented on an output. The
+medians and spreads over all runs are printed as JSON.
+"""
+
+import argparse
+import json
+import os
+import shlex
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+MARKS = ["socket-ready", "first-client-mapped", "first-frame"]
+
+
+def read_marks(path):
+    try:
+        with open(path) as trace:
+            events = json.load(trace)["traceEvents"]
+    except (OSError, ValueError, KeyError):
+        return {}
+
+    return {e["name"]: e["ts"] / 1000 for e in events if e.get("ph") == "i"}
+
+
+def run_once(args, xwayland):
+    with tempfile.TemporaryDirectory(prefix="bench-startup-") as runtime_dir:
+        os.chmod(runtime_dir, 0o700)
+        trace_path = os.path.join(runtime_dir, "startup.json")
+
+        env = dict(os.environ)
+        env.update({
+            "XDG_RUNTIME_DIR": runtime_dir,
+            "KWIN_STARTUP_TRACE": trace_path,
+            "KWIN_DISABLE_RELAUNCH": "1",
+        })
+        env.pop("WAYLAND_DISPLAY", None)
+        env.pop("DISPLAY", None)
+
+        command = ["dbus-run-session", "--", args.binary, "--virtual", "--socket", "bench"]
+        if xwayland:
+            command.append("--xwayland")
+        command += ["--exit-with-session", args.client]
+
+        process = subprocess.Popen(command, env=env, start_new_session=True,
+                                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+        marks = {}
+        deadline = time.monotonic() + args.timeout
+        while time.monotonic() < deadline and process.poll() is None:
+            marks = read_marks(trace_path)
+            if all(name in marks for name in MARKS):
+                break
+            time.sleep(0.05)
+
+        if process.poll() is None:
+            os.killpg(process.pid, signal.SIGTERM)
+            try:
+                process.wait(timeout=10)
+            except subprocess.TimeoutExpired:
+                os.killpg(process.pid, signal.SIGKILL)
+                process.wait()
+
+        return {name: marks.get(name) for name in MARKS}
+
+
+def summarize(samples):
+    values = [value for value in samples if value is not None]
+    if not values:
+        return {"runs": 0, "failed": len(samples)}
+
+    return {
+        "runs": len(values),
+        "failed": len(samples) - len(values),
+        "median_ms": statistics.median(values),
+        "min_ms": min(values),
+        "max_ms": max(values),
+        "stdev_ms": statistics.stdev(values) if len(values) > 1 else 0.0,
+        "samples_ms": values,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--binary", default="kwin_wayland",
+                        help="the compositor to start")
+    parser.add_argument("--runs", type=int, default=10,
+                        help="number of runs per configuration")
+    parser.add_argument("--client", default="weston-simple-shm",
+                        help="client to map, any that shows a window")
+    parser.add_argument("--timeout", type=float, default=30,
+                        help="seconds to wait for all marks of a run")
+    parser.add_argument("--output", help="write the results to this file instead of stdout")
+    args = parser.parse_args()
+
+    results = {
+        "binary": args.binary,
+        "client": args.client,
+        "configurations": {},
+    }
+
+    for name, xwayland in [("wayland", False), ("xwayland", True)]:
+        runs = []
+        for i in range(args.runs):
+            print(f"{name}: run {i + 1} of {args.runs}", file=sys.stderr)
+            runs.append(run_once(args, xwayland))
+
+        command = [args.binary, "--virtual"] + (["--xwayland"] if xwayland else [])
+        results["configurations"][name] = {
+            "command": shlex.join(command),
+            **{mark: summarize([run[mark] for run in runs]) for mark in MARKS},
+        }
+
+    output = json.dumps(results, indent=2)
+    if args.output:
+        with open(args.output, "w") as file:
+            file.write(output + "\n")
+    else:
+        print(output)
+
+    failed = any(result["failed"] for configuration in results["configurations"].values()
+                 for result in configuration.values() if isinstance(result, dict))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,286 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "lazy_xwayland.h"
+
+#include <QDebug>
+#include <array>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace theseus_ship::xwl
+{
+
+namespace
+{
+
+constexpr int max_display{32};
+
+std::string lock_path(int display)
+{
+    return "/tmp/.X" + std::to_string(display) + "-lock";
+}
+
+std::string socket_path(int display)
+{
+    return "/tmp/.X11-unix/X" + std::to_string(display);
+}
+
+int create_lock_file(std::string const& path)
+{
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0444);
+}
+
+bool lock_display(int display)
+{
+    auto const path = lock_path(display);
+    auto fd = create_lock_file(path);
+
+    if (fd < 0 && errno == EEXIST) {
+        // Take over the lock when the server holding it is gone.
+        std::ifstream lock(path);
+        pid_t owner{0};
+        if ((lock >> owner) && kill(owner, 0) < 0 && errno == ESRCH) {
+            unlink(path.c_str());
+            fd = create_lock_file(path);
+        }
+    }
+
+    if (fd < 0) {
+        return false;
+    }
+
+    // Same format as the X server writes: the pid right-aligned in ten characters.
+    std::array<char, 12> content;
+    auto const size = snprintf(content.data(), content.size(), "%10d\n", getpid());
+    auto const written = write(fd, content.data(), size);
+    close(fd);
+
+    if (written != size) {
+        unlink(path.c_str());
+        return false;
+    }
+    return true;
+}
+
+int listen_on(sockaddr_un const& address, socklen_t size)
+{
+    auto fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, reinterpret_cast<sockaddr const*>(&address), size) < 0 || listen(fd, 128) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listen_on_path(std::string const& path)
+{
+    sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    return listen_on(address, sizeof(address));
+}
+
+int listen_on_abstract(std::string const& path)
+{
+    // Abstract socket names start with a null byte and are not null-terminated.
+    sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+    strncpy(address.sun_path + 1, path.c_str(), sizeof(address.sun_path) - 2);
+    return listen_on(address, offsetof(sockaddr_un, sun_path) + 1 + path.size());
+}
+
+long long to_ms(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+}
+
+lazy_xwayland::lazy_xwayland(start_t start)
+    : start{std::move(start)}
+{
+    if (mkdir("/tmp/.X11-unix", 01777) < 0 && errno != EEXIST) {
+        qWarning() << "Failed to create X11 socket directory:" << strerror(errno);
+        return;
+    }
+
+    for (int candidate = 0; candidate < max_display; ++candidate) {
+        if (!lock_display(candidate)) {
+            continue;
+        }
+
+        auto const path = socket_path(candidate);
+        auto const path_fd = listen_on_path(path);
+        auto const abstract_fd = path_fd < 0 ? -1 : listen_on_abstract(path);
+
+        if (abstract_fd < 0) {
+            if (path_fd >= 0) {
+                close(path_fd);
+                unlink(path.c_str());
+            }
+            unlink(lock_path(candidate).c_str());
+            continue;
+        }
+
+        display = candidate;
+        listen_fds = {path_fd, abstract_fd};
+        break;
+    }
+
+    if (display < 0) {
+        qWarning() << "Failed to reserve an X11 display for Xwayland.";
+        return;
+    }
+
+    for (auto fd : listen_fds) {
+        auto notifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Read);
+        QObject::connect(notifier.get(), &QSocketNotifier::activated, notifier.get(), [this] {
+            handle_connection();
+        });
+        notifiers.push_back(std::move(notifier));
+    }
+}
+
+lazy_xwayland::~lazy_xwayland()
+{
+    close_probe();
+    release();
+}
+
+bool lazy_xwayland::is_valid() const
+{
+    return display >= 0;
+}
+
+bool lazy_xwayland::is_started() const
+{
+    return started;
+}
+
+QString lazy_xwayland::display_name() const
+{
+    return QStringLiteral(":") + QString::number(display);
+}
+
+void lazy_xwayland::handle_connection()
+{
+    if (started) {
+        return;
+    }
+
+    // Might be called from a notifier's own activation, so do not delete them right away.
+    for (auto& notifier : notifiers) {
+        notifier->setEnabled(false);
+        notifier.release()->deleteLater();
+    }
+    notifiers.clear();
+
+    // The connection is left pending. Xwayland accepts it on the handed over sockets.
+    started = true;
+    connected = std::chrono::steady_clock::now();
+    start(display, std::move(listen_fds));
+    listen_fds.clear();
+    launch = std::chrono::steady_clock::now() - connected;
+
+    probe();
+}
+
+void lazy_xwayland::probe()
+{
+    probe_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (probe_fd < 0) {
+        return;
+    }
+
+    // Connecting succeeds while the connection waits in the backlog for Xwayland to accept it.
+    auto const path = socket_path(display);
+    sockaddr_un address{.sun_family = AF_UNIX, .sun_path = {}};
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (connect(probe_fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) < 0) {
+        qWarning() << "Failed to probe Xwayland:" << strerror(errno);
+        close_probe();
+        return;
+    }
+
+    // Connection setup without authorization: byte order, unused, protocol version 11.0, the
+    // lengths of the authorization name and data and two bytes of padding.
+    std::array<uint8_t, 12> setup{};
+    setup[0] = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 'l' : 'B';
+    uint16_t const major{11};
+    memcpy(&setup[2], &major, sizeof(major));
+
+    if (write(probe_fd, setup.data(), setup.size()) != static_cast<ssize_t>(setup.size())) {
+        qWarning() << "Failed to probe Xwayland:" << strerror(errno);
+        close_probe();
+        return;
+    }
+
+    probe_notifier = std::make_unique<QSocketNotifier>(probe_fd, QSocketNotifier::Read);
+    QObject::connect(probe_notifier.get(),
+                     &QSocketNotifier::activated,
+                     probe_notifier.get(),
+                     [this] { handle_probe_reply(); });
+}
+
+void lazy_xwayland::handle_probe_reply()
+{
+    // Any answer counts, also a refusal for the missing authorization. Nothing is read on EOF.
+    uint8_t status{0};
+    if (read(probe_fd, &status, sizeof(status)) == sizeof(status)) {
+        qInfo("Served the first X11 client %lld ms after it connected. Launching Xwayland on "
+              "demand took %lld ms of it.",
+              to_ms(std::chrono::steady_clock::now() - connected),
+              to_ms(launch));
+    } else {
+        qWarning() << "Xwayland closed the probe connection without serving it.";
+    }
+
+    // Might be called from the notifier's own activation.
+    probe_notifier->setEnabled(false);
+    probe_notifier.release()->deleteLater();
+    close_probe();
+}
+
+void lazy_xwayland::close_probe()
+{
+    probe_notifier.reset();
+    if (probe_fd >= 0) {
+        close(probe_fd);
+        probe_fd = -1;
+    }
+}
+
+void lazy_xwayland::release()
+{
+    if (started) {
+        return;
+    }
+    notifiers.clear();
+
+    for (auto fd : listen_fds) {
+        close(fd);
+    }
+    listen_fds.clear();
+
+    if (display >= 0) {
+        unlink(socket_path(display).c_str());
+        unlink(lock_path(display).c_str());
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+SPDX-FileCopyrightText: 2026 Theseus' Ship Developers
+
+SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#pragma once
+
+#include <QSocketNotifier>
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace theseus_ship::xwl
+{
+
+/**
+ * Reserves an X11 display by holding its lock file and listening sockets, so DISPLAY can be
+ * exported before Xwayland runs. When the first X11 client connects the start callback is called
+ * with the display and its listening sockets to launch Xwayland on them.
+ *
+ * Connections stay pending on the sockets until Xwayland accepts them, so early clients reach the
+ * server directly. The lock file and sockets belong to Xwayland from then on.
+ *
+ * To report the warm-path latency a probe connection is queued behind the first client. Pending
+ * connections are accepted in order, so once Xwayland answers the probe's connection setup the
+ * first client has been accepted and served as well. The time from the first connection until
+ * then is logged.
+ */
+class lazy_xwayland
+{
+public:
+    using start_t = std::function<void(int display, std::vector<int> listen_fds)>;
+
+    explicit lazy_xwayland(start_t start);
+    ~lazy_xwayland();
+
+    bool is_valid() const;
+    bool is_started() const;
+    QString display_name() const;
+
+private:
+    void handle_connection();
+    void probe();
+    void handle_probe_reply();
+    void close_probe();
+    void release();
+
+    start_t start;
+    int display{-1};
+    std::vector<int> listen_fds;
+    std::vector<std::unique_ptr<QSocketNotifier>> notifiers;
+    bool started{false};
+
+    std::chrono::steady_clock::time_point connected;
+    std::chrono::steady_clock::duration launch{0};
+    int probe_fd{-1};
+    std::unique_ptr<QSocketNotifier> probe_notifier;
+};
+
+}